@@ -0,0 +1,227 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/*
+ * Aggregates incumbent trajectories (as written by the TRAJECTORY setting of
+ * the solvers) into, for each instance class (number of patients):
+ * - time-to-target (TTT) distributions: for each relative gap, the time each
+ *   run took to reach a solution within that gap from the best cost known for
+ *   its instance (the best among all runs in the file);
+ * - average anytime curves: mean relative gap of the incumbent along time.
+ *
+ * Writes <prefix>-ttt.csv and <prefix>-anytime.csv, and prints a summary.
+ * Does not depend on CPLEX.
+ */
+
+#include "Instance.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+namespace {
+
+struct TrajPoint {
+   double time;
+   double obj;
+};
+
+struct Run {
+   string instance;
+   int cls = 0;
+   vector <TrajPoint> points;
+
+   /** Incumbent cost at time `t`. */
+   double objAt(double t) const {
+      double obj = points.front().obj;
+      for (const TrajPoint &p: points) {
+         if (p.time > t)
+            break;
+         obj = p.obj;
+      }
+      return obj;
+   }
+};
+
+}
+
+int main(int argc, char **argv) {
+   if (argc < 3) {
+      cout << "Usage: " << argv[0] << " <1: trajectory csv> <2: output prefix> [3...: target gaps, default 0 0.01 0.05]" << endl;
+      return EXIT_FAILURE;
+   }
+
+   vector <double> gaps;
+   for (int a = 3; a < argc; ++a)
+      gaps.push_back(atof(argv[a]));
+   if (gaps.empty())
+      gaps = {0.0, 0.01, 0.05};
+
+   // Reads the runs, keyed by their id: the same (instance, seed) may have
+   // been run several times, e.g. with other settings.
+   map <string, Run> runsByKey;
+   {
+      ifstream fid(argv[1]);
+      if (!fid) {
+         cout << "Trajectory file " << argv[1] << " could not be read." << endl;
+         return EXIT_FAILURE;
+      }
+
+      string line;
+      while (getline(fid, line)) {
+         if (line.empty() || line.compare(0, 9, "instance,") == 0)
+            continue;
+
+         vector <string> cols;
+         istringstream row(line);
+         string col;
+         while (getline(row, col, ','))
+            cols.push_back(col);
+         if (cols.size() != 7) {
+            cout << "Malformed trajectory line: " << line << endl;
+            return EXIT_FAILURE;
+         }
+
+         Run &run = runsByKey[cols[6]];
+         const TrajPoint point{stod(cols[3]), stod(cols[4])};
+         if (!run.points.empty() && (run.instance != cols[0] || point.time < run.points.back().time)) {
+            cout << "Inconsistent trajectory of run " << cols[6] << ": " << line << endl;
+            return EXIT_FAILURE;
+         }
+         run.instance = cols[0];
+         run.points.push_back(point);
+      }
+   }
+
+   if (runsByKey.empty()) {
+      cout << "No runs found in " << argv[1] << "." << endl;
+      return EXIT_FAILURE;
+   }
+
+   // Best known cost and class of each instance.
+   map <string, double> bestKnown;
+   map <string, int> instClass;
+   for (auto &entry: runsByKey) {
+      Run &run = entry.second;
+      if (!instClass.count(run.instance)) {
+         try {
+            Instance inst(run.instance.c_str(), Instance::DistanceMode::FULL, false);
+            instClass[run.instance] = inst.numNodes() - 2;
+         } catch (const exception &e) {
+            cout << e.what() << endl;
+            return EXIT_FAILURE;
+         }
+         bestKnown[run.instance] = numeric_limits<double>::infinity();
+      }
+      run.cls = instClass[run.instance];
+      for (const TrajPoint &p: run.points)
+         bestKnown[run.instance] = min(bestKnown[run.instance], p.obj);
+   }
+
+   map <int, vector <const Run*>> runsByClass;
+   for (const auto &entry: runsByKey)
+      runsByClass[entry.second.cls].push_back(&entry.second);
+
+   const string prefix = argv[2];
+   ofstream ttt(prefix + "-ttt.csv");
+   ofstream anytime(prefix + "-anytime.csv");
+   if (!ttt || !anytime) {
+      cout << "Output files with prefix " << prefix << " could not be written." << endl;
+      return EXIT_FAILURE;
+   }
+
+   ttt << "class,gap,rank,time,prob\n";
+   anytime << "class,time,avg.gap,runs\n";
+
+   cout << setw(8) << "class" << setw(8) << "gap" << setw(8) << "runs" << setw(9) << "reached" <<
+      setw(14) << "median (s)" << setw(14) << "mean (s)" << "\n";
+
+   for (const auto &entry: runsByClass) {
+      const int cls = entry.first;
+      const vector <const Run*> &runs = entry.second;
+
+      // Time-to-target distributions. Runs that do not reach the target are
+      // censored: they count in the probabilities but have no time.
+      for (double gap: gaps) {
+         vector <double> times;
+         for (const Run *run: runs) {
+            const double target = bestKnown[run->instance] * (1.0 + gap) + 1e-6;
+            for (const TrajPoint &p: run->points) {
+               if (p.obj <= target) {
+                  times.push_back(p.time);
+                  break;
+               }
+            }
+         }
+         sort(times.begin(), times.end());
+
+         double mean = 0.0;
+         for (size_t k = 0; k < times.size(); ++k) {
+            ttt << cls << "," << gap << "," << k+1 << "," << times[k] << "," <<
+               (double(k) + 0.5) / double(runs.size()) << "\n";
+            mean += times[k];
+         }
+
+         cout << setw(8) << cls << setw(8) << gap << setw(8) << runs.size() << setw(9) << times.size() <<
+            fixed << setprecision(2);
+         if (times.empty())
+            cout << setw(14) << "-" << setw(14) << "-" << "\n";
+         else
+            cout << setw(14) << times[times.size()/2] << setw(14) << mean / double(times.size()) << "\n";
+         cout.unsetf(ios::floatfield);
+         cout << setprecision(6);
+      }
+
+      // Anytime curve over a regular grid, up to the longest run.
+      double horizon = 0.0;
+      for (const Run *run: runs)
+         horizon = max(horizon, run->points.back().time);
+
+      const int steps = 100;
+      for (int k = 0; k <= steps; ++k) {
+         const double t = horizon * k / steps;
+         double sumGap = 0.0;
+         for (const Run *run: runs)
+            sumGap += run->objAt(t) / bestKnown[run->instance] - 1.0;
+         anytime << cls << "," << t << "," << sumGap / double(runs.size()) << "," << runs.size() << "\n";
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Collects running times of microbenchmarks, grouped by instance class
+ * (number of patients), and prints summary statistics of them.
+ */
+class BenchReport {
+public:
+   /**
+    * Runs `func` `reps` times, registering the time of each run.
+    */
+   template <typename Func>
+   void measure(const std::string &name, int cls, int reps, Func &&func) {
+      for (int r = 0; r < reps; ++r) {
+         auto t0 = std::chrono::steady_clock::now();
+         func();
+         auto t1 = std::chrono::steady_clock::now();
+         add(name, cls, std::chrono::duration<double, std::milli>(t1 - t0).count());
+      }
+   }
+
+   /**
+    * Registers a time (in milliseconds) measured elsewhere.
+    */
+   void add(const std::string &name, int cls, double ms) {
+      if (std::find(m_names.begin(), m_names.end(), name) == m_names.end())
+         m_names.push_back(name);
+      m_times[std::make_pair(name, cls)].push_back(ms);
+   }
+
+   /**
+    * Prints one line per benchmark and class, in order of registration.
+    */
+   void print(std::ostream &out) const {
+      out << std::left << std::setw(28) << "benchmark" << std::right << std::setw(8) << "class" <<
+         std::setw(9) << "samples" << std::setw(14) << "avg (ms)" << std::setw(14) << "median (ms)" <<
+         std::setw(14) << "min (ms)" << "\n";
+
+      for (const std::string &name: m_names) {
+         for (const auto &entry: m_times) {
+            if (entry.first.first != name)
+               continue;
+
+            std::vector <double> t = entry.second;
+            std::sort(t.begin(), t.end());
+            double avg = 0.0;
+            for (double v: t)
+               avg += v;
+            avg /= double(t.size());
+
+            out << std::left << std::setw(28) << name << std::right << std::setw(8) << entry.first.second <<
+               std::setw(9) << t.size() << std::fixed << std::setprecision(3) <<
+               std::setw(14) << avg << std::setw(14) << t[t.size()/2] << std::setw(14) << t.front() << "\n";
+         }
+      }
+   }
+
+private:
+   std::vector <std::string> m_names;
+   std::map <std::pair<std::string, int>, std::vector<double>> m_times;
+};
@@ -0,0 +1,180 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/*
+ * Microbenchmarks of the hot paths of the solver, for each instance class
+ * (number of patients) among the files given in the command line:
+ * - instance loading (text and binary cache);
+ * - MIP model construction, per family of constraints;
+ * - initial routing heuristic and its copy into the MIP model;
+ * - fixing/unfixing the current solution;
+ * - service start time queries and the guided vehicle selection.
+ *
+ * Cheap benchmarks are repeated as many times as requested. The MIP model is
+ * built once per file.
+ */
+
+#include "Benchmark.h"
+#include "FixAndOptimize.h"
+#include "InitialRouting.h"
+#include "Instance.h"
+#include "MipModel.h"
+#include "SolutionCopy.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+
+using namespace std;
+
+/**
+ * Exposes the vehicle selection of the fix-and-optimize to the benchmarks.
+ */
+class BenchFixAndOptimize: public FixAndOptimize {
+public:
+   BenchFixAndOptimize(MipModel &model): FixAndOptimize(model) {
+      // Empty
+   }
+
+   void select(DecompMethod method) {
+      m_currentDecomp = method;
+      selectDecompVehicles();
+   }
+};
+
+int main(int argc, char **argv) {
+   if (argc < 3) {
+      cout << "Usage: " << argv[0] << " <1: repetitions> <2...: instance paths>" << endl;
+      return EXIT_FAILURE;
+   }
+
+   const int reps = max(1, atoi(argv[1]));
+
+   auto elapsedMs = [] (chrono::steady_clock::time_point t0) {
+      return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+   };
+
+   BenchReport report;
+   for (int f = 2; f < argc; ++f) {
+      cout << "Running " << argv[f] << "..." << endl;
+
+      Instance inst(argv[f]);
+      const int cls = inst.numNodes() - 2;
+
+      report.measure("instance: parse text", cls, reps, [&] () {
+         Instance other(argv[f], Instance::DistanceMode::FULL, false);
+      });
+      report.measure("instance: load cache", cls, reps, [&] () {
+         Instance other(argv[f], Instance::DistanceMode::FULL, true);
+      });
+
+      auto t0 = chrono::steady_clock::now();
+      unique_ptr <MipModel> model(new MipModel(inst));
+      report.add("model: total", cls, elapsedMs(t0));
+      for (const auto &family: model->buildTimes())
+         report.add("model: " + family.first, cls, family.second * 1000.0);
+
+      model->setQuiet(true);
+      model->maxThreads(1);
+
+      // The aggregated formulation must give the same cost to the same routes.
+      t0 = chrono::steady_clock::now();
+      unique_ptr <MipModel> aggregated(new MipModel(inst, "", MipModel::Formulation::AGGREGATED));
+      report.add("model (aggregated): total", cls, elapsedMs(t0));
+      for (const auto &family: aggregated->buildTimes())
+         report.add("model (aggregated): " + family.first, cls, family.second * 1000.0);
+      aggregated->setQuiet(true);
+      aggregated->maxThreads(1);
+      cout << "  Nonzeros: " << model->modelStats().nonzeros << " (vehicle), " <<
+         aggregated->modelStats().nonzeros << " (aggregated)" << endl;
+
+      InitialRouting iniSol(inst);
+      report.measure("initial routing: solve", cls, reps, [&] () {
+         iniSol.solve();
+      });
+      report.measure("solution copy", cls, reps, [&] () {
+         solutionCopy(iniSol, *model);
+      });
+
+      model->solve();
+
+      solutionCopy(iniSol, *aggregated);
+      const double aggregatedObj = aggregated->solve();
+      if (fabs(aggregatedObj - model->objValue()) > 1e-6)
+         cout << "  Formulations disagree on the initial solution: " << model->objValue() << " (vehicle), " <<
+            aggregatedObj << " (aggregated)" << endl;
+      aggregated.reset();
+
+      report.measure("service start times", cls, reps, [&] () {
+         double sum = 0.0;
+         for (int i = 1; i < inst.numNodes()-1; ++i)
+            for (int v = 0; v < inst.numVehicles(); ++v)
+               for (int s = 0; s < inst.numSkills(); ++s)
+                  if (model->serviceStartTime(i, v, s) != numeric_limits<double>::infinity())
+                     sum += 1.0;
+         (void) sum;
+      });
+
+      BenchFixAndOptimize feo(*model);
+      report.measure("decomp: guided selection", cls, reps, [&] () {
+         feo.select(FixAndOptimize::DecompMethod::GUIDED);
+      });
+      report.measure("decomp: random selection", cls, reps, [&] () {
+         feo.select(FixAndOptimize::DecompMethod::RANDOM);
+      });
+      report.measure("decomp: visits selection", cls, reps, [&] () {
+         feo.select(FixAndOptimize::DecompMethod::VISITS);
+      });
+      report.measure("decomp: tardy selection", cls, reps, [&] () {
+         feo.select(FixAndOptimize::DecompMethod::TARDY);
+      });
+
+      // Fixing reads the solution from CPLEX, so the (already fixed) model
+      // is solved again before each repetition.
+      for (int r = 0; r < reps; ++r) {
+         model->solve();
+         t0 = chrono::steady_clock::now();
+         model->fixCurrentSolution();
+         report.add("fix current solution", cls, elapsedMs(t0));
+      }
+
+      int v = 0;
+      report.measure("unfix vehicle solution", cls, reps, [&] () {
+         model->unfixVehicleSolution(v);
+         v = (v + 1) % inst.numVehicles();
+      });
+   }
+
+   cout << "\n";
+   report.print(cout);
+   return EXIT_SUCCESS;
+}
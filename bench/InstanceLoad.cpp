@@ -0,0 +1,69 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/*
+ * Microbenchmark of instance loading.
+ * Reports load times of each instance class (number of patients) among the
+ * files given in the command line, both parsing the text files and reading
+ * their binary caches. Does not depend on CPLEX.
+ */
+
+#include "Benchmark.h"
+#include "Instance.h"
+
+#include <cstdlib>
+#include <iostream>
+
+
+using namespace std;
+
+int main(int argc, char **argv) {
+   if (argc < 3) {
+      cout << "Usage: " << argv[0] << " <1: repetitions> <2...: instance paths>" << endl;
+      return EXIT_FAILURE;
+   }
+
+   const int reps = max(1, atoi(argv[1]));
+
+   BenchReport report;
+   for (int f = 2; f < argc; ++f) {
+      // Makes sure the cache exists before timing it.
+      Instance warmup(argv[f]);
+      const int cls = warmup.numNodes() - 2;
+
+      report.measure("parse text", cls, reps, [&] () {
+         Instance inst(argv[f], Instance::DistanceMode::FULL, false);
+      });
+      report.measure("load cache", cls, reps, [&] () {
+         Instance inst(argv[f], Instance::DistanceMode::FULL, true);
+      });
+   }
+
+   report.print(cout);
+   return EXIT_SUCCESS;
+}
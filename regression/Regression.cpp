@@ -0,0 +1,342 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/*
+ * End-to-end performance regression suite.
+ *
+ * Runs the fix-and-optimize on the (instance, seed) cases of a baseline CSV
+ * file, using a single thread and deterministic time limits (CPLEX ticks) on
+ * the subproblems, and compares the final cost, time.best and time.total
+ * with the stored values:
+ * - cost fails when it is larger than the baseline by more than the
+ *   relative cost tolerance;
+ * - times fail when they are larger than the baseline by more than the
+ *   relative time tolerance plus an absolute slack (in seconds).
+ * Before its run, each case also checks that reduced-cost fixing survives a
+ * failed subproblem (see `checkReducedCostRestore`).
+ * Cases without stored values are reported as "new", and fail unless
+ * `--allow-new` is given, so an empty baseline does not pass. With
+ * `--update`, the baseline file is rewritten with the values of this run.
+ *
+ * The exit status is EXIT_FAILURE when any case fails.
+ */
+
+#include "InitialRouting.h"
+#include "Instance.h"
+#include "MipModel.h"
+#include "Runner.h"
+#include "SolutionCopy.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+using namespace std;
+
+namespace {
+
+struct RegressionCase {
+   string instance;
+   long seed = 0;
+   double ticks = 0.0;
+
+   bool hasBaseline = false;
+   double cost = 0.0;
+   double timeBest = 0.0;
+   double timeTotal = 0.0;
+
+   RunResult result;
+   string status;
+};
+
+const char *baselineHeader = "instance,seed,ticks,cost,time.best,time.total";
+
+bool readBaseline(const string &fname, vector <RegressionCase> &cases) {
+   ifstream fid(fname);
+   if (!fid)
+      return false;
+
+   string line;
+   while (getline(fid, line)) {
+      line.erase(line.find_last_not_of(" \t\r") + 1);
+      if (line.empty() || line[0] == '#' || line == baselineHeader)
+         continue;
+
+      vector <string> cols;
+      istringstream row(line);
+      string col;
+      while (getline(row, col, ','))
+         cols.push_back(col);
+
+      if (cols.size() < 3) {
+         cout << "Malformed baseline line: " << line << endl;
+         return false;
+      }
+
+      RegressionCase c;
+      c.instance = cols[0];
+      c.seed = stol(cols[1]);
+      c.ticks = stod(cols[2]);
+      if (cols.size() == 6 && !cols[3].empty()) {
+         c.hasBaseline = true;
+         c.cost = stod(cols[3]);
+         c.timeBest = stod(cols[4]);
+         c.timeTotal = stod(cols[5]);
+      }
+      cases.push_back(c);
+   }
+   return true;
+}
+
+/**
+ * Removes arcs by reduced cost, goes back to the incumbent the way
+ * `FixAndOptimize` does after a subproblem without solution, and checks
+ * that the relaxation is still available and removes the same arcs again.
+ * Returns false with the problem found in `error`.
+ */
+bool checkReducedCostRestore(const Instance &inst, MipModel::Formulation formulation, string &error) {
+   MipModel model(inst, "", formulation);
+   model.setQuiet(true);
+   model.maxThreads(1);
+   model.timeLimit(600);
+
+   InitialRouting iniSol(inst);
+   iniSol.solve();
+   solutionCopy(iniSol, model);
+   if (!model.trySolve()) {
+      error = "initial solution is infeasible";
+      return false;
+   }
+   const double obj = model.objValue();
+   const auto routes = model.routes();
+
+   if (!model.solveRelaxation()) {
+      error = "relaxation not solved";
+      return false;
+   }
+   model.fixCurrentSolution();
+   const int removed = model.removeArcsByReducedCost(obj);
+
+   model.unfixSolution();
+   model.setRoutes(routes);
+   if (!model.trySolve()) {
+      error = "incumbent not restored";
+      return false;
+   }
+   if (!model.hasRelaxation()) {
+      error = "relaxation lost after restoring the removed arcs";
+      return false;
+   }
+
+   model.fixCurrentSolution();
+   const int again = model.removeArcsByReducedCost(obj);
+   if (again != removed) {
+      error = "removed " + to_string(removed) + " arcs, then " + to_string(again);
+      return false;
+   }
+   return true;
+}
+
+bool writeBaseline(const string &fname, const vector <RegressionCase> &cases) {
+   ofstream fid(fname);
+   if (!fid)
+      return false;
+
+   fid << "# Regression cases: instance file (relative to the instance directory), seed\n"
+      "# and deterministic time limit of each subproblem (CPLEX ticks). The stored\n"
+      "# results are filled by running the suite with --update.\n";
+   fid << baselineHeader << "\n";
+   for (const RegressionCase &c: cases) {
+      fid << c.instance << "," << c.seed << "," << c.ticks << "," <<
+         setprecision(10) << c.result.cost << "," <<
+         setprecision(4) << c.result.timeBest << "," << c.result.timeTotal << "\n";
+   }
+   return bool(fid);
+}
+
+void writeReport(ostream &out, const vector <RegressionCase> &cases, double costTol, double timeTol,
+   double timeSlack) {
+   out << setprecision(10);
+   out << "{\n";
+   out << "  \"cost_tolerance\": " << costTol << ",\n";
+   out << "  \"time_tolerance\": " << timeTol << ",\n";
+   out << "  \"time_slack\": " << timeSlack << ",\n";
+   out << "  \"cases\": [\n";
+   for (size_t k = 0; k < cases.size(); ++k) {
+      const RegressionCase &c = cases[k];
+      out << "    {\"instance\": \"" << jsonEscape(c.instance) << "\", \"seed\": " << c.seed <<
+         ", \"ticks\": " << c.ticks << ", \"status\": \"" << c.status << "\"" <<
+         ", \"cost\": " << c.result.cost <<
+         ", \"time_best\": " << c.result.timeBest <<
+         ", \"time_total\": " << c.result.timeTotal;
+      if (c.hasBaseline) {
+         out << ", \"baseline\": {\"cost\": " << c.cost << ", \"time_best\": " << c.timeBest <<
+            ", \"time_total\": " << c.timeTotal << "}";
+      }
+      out << "}" << (k+1 < cases.size() ? "," : "") << "\n";
+   }
+   out << "  ]\n";
+   out << "}\n";
+}
+
+}
+
+int main(int argc, char **argv) {
+   bool update = false;
+   bool allowNew = false;
+   string reportFile;
+   double costTol = 1e-4;
+   double timeTol = 0.25;
+   double timeSlack = 1.0;
+   MipModel::Formulation formulation = MipModel::Formulation::VEHICLE;
+
+   int arg = 1;
+   for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; ++arg) {
+      if (strcmp(argv[arg], "--update") == 0) {
+         update = true;
+      } else if (strcmp(argv[arg], "--allow-new") == 0) {
+         allowNew = true;
+      } else if (strcmp(argv[arg], "--report") == 0 && arg+1 < argc) {
+         reportFile = argv[++arg];
+      } else if (strcmp(argv[arg], "--cost-tol") == 0 && arg+1 < argc) {
+         costTol = atof(argv[++arg]);
+      } else if (strcmp(argv[arg], "--time-tol") == 0 && arg+1 < argc) {
+         timeTol = atof(argv[++arg]);
+      } else if (strcmp(argv[arg], "--time-slack") == 0 && arg+1 < argc) {
+         timeSlack = atof(argv[++arg]);
+      } else if (strcmp(argv[arg], "--formulation") == 0 && arg+1 < argc) {
+         if (!MipModel::parseFormulation(argv[++arg], formulation)) {
+            cout << "Unknown formulation: " << argv[arg] << endl;
+            return EXIT_FAILURE;
+         }
+      } else {
+         break;
+      }
+   }
+
+   if (argc - arg != 2) {
+      cout << "Usage: " << argv[0] << " [--update] [--allow-new] [--report <json file>] [--cost-tol <rel>] "
+         "[--time-tol <rel>] [--time-slack <secs>] [--formulation <name>] <1: baseline csv> <2: instance directory>" << endl;
+      return EXIT_FAILURE;
+   }
+
+   const string baselineFile = argv[arg];
+   const string instanceDir = argv[arg+1];
+
+   vector <RegressionCase> cases;
+   if (!readBaseline(baselineFile, cases)) {
+      cout << "Baseline file " << baselineFile << " could not be read." << endl;
+      return EXIT_FAILURE;
+   }
+   if (cases.empty()) {
+      cout << "Baseline file " << baselineFile << " has no cases." << endl;
+      return EXIT_FAILURE;
+   }
+
+   cout << "=== Fix-and-Optimize regression suite for HHCRSP ===\n";
+   cout << "Cases: " << cases.size() << "  Cost tolerance: " << costTol << "  Time tolerance: " <<
+      timeTol << " + " << timeSlack << " secs" << endl;
+
+   int failures = 0;
+   for (RegressionCase &c: cases) {
+      const string path = instanceDir + "/" + c.instance;
+      Instance inst(path.c_str(), Instance::DistanceMode::FULL, false);
+
+      string checkError;
+      const bool checkOk = checkReducedCostRestore(inst, formulation, checkError);
+
+      RunSettings settings;
+      settings.seed = c.seed;
+      settings.maxIterTicks = c.ticks;
+      settings.formulation = formulation;
+      // The deterministic limit is the binding one; the wall-clock limit only
+      // protects the suite against runaway subproblems.
+      settings.maxIterSeconds = 3600;
+
+      c.result = runFixAndOptimize(inst, settings);
+
+      if (!checkOk) {
+         c.status = "check failed: " + checkError;
+      } else if (!c.hasBaseline) {
+         c.status = "new";
+      } else {
+         const bool costOk = c.result.cost <= c.cost * (1.0 + costTol) + 1e-6;
+         const bool bestOk = c.result.timeBest <= c.timeBest * (1.0 + timeTol) + timeSlack;
+         const bool totalOk = c.result.timeTotal <= c.timeTotal * (1.0 + timeTol) + timeSlack;
+         if (!costOk)
+            c.status = "cost regression";
+         else if (!bestOk || !totalOk)
+            c.status = "time regression";
+         else
+            c.status = "pass";
+      }
+      if (c.status != "pass" && (c.status != "new" || !allowNew))
+         ++failures;
+
+      cout << c.instance << "  seed: " << c.seed << fixed << setprecision(2) <<
+         "  cost: " << c.result.cost;
+      if (c.hasBaseline)
+         cout << " (" << c.cost << ")";
+      cout << "  time.best: " << c.result.timeBest;
+      if (c.hasBaseline)
+         cout << " (" << c.timeBest << ")";
+      cout << "  time.total: " << c.result.timeTotal;
+      if (c.hasBaseline)
+         cout << " (" << c.timeTotal << ")";
+      cout << "  " << c.status << endl;
+      cout.unsetf(ios::floatfield);
+   }
+
+   if (!reportFile.empty()) {
+      ofstream fid(reportFile);
+      if (!fid) {
+         cout << "Report file " << reportFile << " could not be written." << endl;
+         return EXIT_FAILURE;
+      }
+      writeReport(fid, cases, costTol, timeTol, timeSlack);
+   }
+
+   if (update) {
+      if (!writeBaseline(baselineFile, cases)) {
+         cout << "Baseline file " << baselineFile << " could not be written." << endl;
+         return EXIT_FAILURE;
+      }
+      cout << "Baseline " << baselineFile << " updated." << endl;
+      return EXIT_SUCCESS;
+   }
+
+   cout << "\n" << failures << " of " << cases.size() << " cases failed." << endl;
+   return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
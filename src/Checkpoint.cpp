@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Checkpoint.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <unistd.h>
+
+
+using namespace std;
+
+namespace {
+
+const char *checkpointMagic = "HHCRSP-CHECKPOINT";
+const int checkpointVersion = 1;
+
+}
+
+bool Checkpoint::write(const std::string &path, const Instance &inst) const {
+   const string tmp = path + ".tmp" + to_string(getpid());
+   {
+      ofstream fid(tmp);
+      if (!fid) {
+         cout << "Checkpoint file " << tmp << " could not be written." << endl;
+         return false;
+      }
+
+      fid << setprecision(17);
+      fid << checkpointMagic << " " << checkpointVersion << "\n";
+      fid << "hash " << hex << instanceHash << dec << "\n";
+      fid << "seed " << seed << "\n";
+      fid << "iter " << iter << " " << itersWoImpr << "\n";
+      fid << "obj " << obj << "\n";
+      fid << "time " << timeBest << " " << elapsed << "\n";
+      fid << "prng " << prngState << "\n";
+
+      fid << "trajectory " << trajectory.size() << "\n";
+      for (const IncumbentPoint &p: trajectory)
+         fid << p.time << " " << p.obj << " " << p.iter << " " << p.decomp << "\n";
+
+      fid << "routes\n";
+      writeSolution(fid, inst, routes, obj, SolutionFormat::TEXT);
+
+      if (!fid) {
+         cout << "Checkpoint file " << tmp << " could not be written." << endl;
+         remove(tmp.c_str());
+         return false;
+      }
+   }
+
+   if (rename(tmp.c_str(), path.c_str()) != 0) {
+      remove(tmp.c_str());
+      return false;
+   }
+   return true;
+}
+
+bool Checkpoint::read(const std::string &path, const Instance &inst, std::string &error) {
+   ifstream fid(path);
+   if (!fid) {
+      error = "file can not be read";
+      return false;
+   }
+
+   string magic, key;
+   int version = 0;
+   if (!(fid >> magic >> version) || magic != checkpointMagic || version != checkpointVersion) {
+      error = "not a checkpoint of this version";
+      return false;
+   }
+
+   size_t count = 0;
+   bool ok = bool(fid >> key >> hex >> instanceHash >> dec) && key == "hash";
+   ok = ok && fid >> key >> seed && key == "seed";
+   ok = ok && fid >> key >> iter >> itersWoImpr && key == "iter";
+   ok = ok && fid >> key >> obj && key == "obj";
+   ok = ok && fid >> key >> timeBest >> elapsed && key == "time";
+   ok = ok && fid >> key && key == "prng" && getline(fid, prngState);
+
+   ok = ok && fid >> key >> count && key == "trajectory";
+   trajectory.clear();
+   for (size_t k = 0; ok && k < count; ++k) {
+      IncumbentPoint p;
+      ok = bool(fid >> p.time >> p.obj >> p.iter >> p.decomp);
+      trajectory.push_back(p);
+   }
+
+   ok = ok && fid >> key && key == "routes";
+   if (!ok || trajectory.empty()) {
+      error = "malformed checkpoint";
+      return false;
+   }
+   if (instanceHash != inst.contentHash()) {
+      error = "checkpoint written for another instance";
+      return false;
+   }
+
+   return readSolution(fid >> ws, inst, routes, error);
+}
@@ -0,0 +1,81 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "ResultsLog.h"
+#include "SolutionFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * State of a fix-and-optimize run, saved periodically so that the run can be
+ * resumed after being interrupted: the routes of the incumbent, iteration
+ * counters, elapsed times, the state of the PRNG and the incumbent
+ * trajectory so far.
+ */
+struct Checkpoint {
+   /** Content hash of the instance (see `Instance::contentHash`). */
+   uint64_t instanceHash = 0;
+   long seed = 0;
+
+   /** Last iteration done, and iterations without improvement so far. */
+   int iter = 0;
+   int itersWoImpr = 0;
+
+   double obj = 0.0;
+   double timeBest = 0.0;
+   double elapsed = 0.0;
+
+   /** State of the PRNG, as written by its `operator<<`. */
+   std::string prngState;
+
+   std::vector <IncumbentPoint> trajectory;
+
+   /**
+    * Visits (node, skill) of each vehicle, excluding the depot, stored as a
+    * solution file section (see `SolutionFile.h`).
+    */
+   SolutionRoutes routes;
+
+   /**
+    * Writes the checkpoint of a run on `inst` into `path`, atomically
+    * (through a temporary file).
+    */
+   bool write(const std::string &path, const Instance &inst) const;
+
+   /**
+    * Reads the checkpoint from `path`. Returns false, with the reason in
+    * `error`, if the file does not exist, is not a valid checkpoint, belongs
+    * to another instance or its routes are not a feasible solution of `inst`
+    * (see `validateRoutes`).
+    */
+   bool read(const std::string &path, const Instance &inst, std::string &error);
+};
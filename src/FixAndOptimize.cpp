@@ -29,96 +29,389 @@
 #include "Timer.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
 
 
 using namespace std;
 
 
-FixAndOptimize::FixAndOptimize(MipModel& model): m_inst(model.instance()), m_model(model) {
-   // Empty
+FixAndOptimize::FixAndOptimize(MipModel& model): m_inst(model.instance()), m_model(model),
+   m_verbose(true), m_trace(nullptr), m_timeBudget(0.0), m_symmetryBreaking(false), m_relaxationTried(false),
+   m_relaxationSolved(false), m_reducedCostFixing(false), m_boundPropagation(false), m_partnerTiming(false), m_bounder(nullptr), m_stopGap(0.0),
+   m_checkpointInterval(0.0), m_archive(nullptr), m_archiveInterval(0.0), m_resume(nullptr), m_timeBest(0.0), m_timeTotal(0.0) {
+   m_decomps = {DecompMethod::RANDOM, DecompMethod::GUIDED};
 }
 
 FixAndOptimize::~FixAndOptimize() {
    // Empty
 }
 
-void FixAndOptimize::solve(const int seed, const int maxIterNoImpr, const int maxIterSeconds) {
+const char *FixAndOptimize::decompName(DecompMethod method) {
+   switch (method) {
+      case DecompMethod::RANDOM: return "random";
+      case DecompMethod::GUIDED: return "guided";
+      case DecompMethod::LP_GUIDED: return "lp";
+      case DecompMethod::VISITS: return "visits";
+      case DecompMethod::SYNC: return "sync";
+      case DecompMethod::TARDY: return "tardy";
+      default: return "unknown";
+   }
+}
+
+bool FixAndOptimize::parseDecompositions(const string &list, vector <DecompMethod> &methods) {
+   methods.clear();
+   istringstream in(list);
+   string name;
+   while (getline(in, name, ',')) {
+      int m = 0;
+      while (m < (int) DecompMethod::MAX_ && name != decompName((DecompMethod) m))
+         ++m;
+      if (m == (int) DecompMethod::MAX_)
+         return false;
+      methods.push_back((DecompMethod) m);
+   }
+   return !methods.empty();
+}
+
+void FixAndOptimize::solve(const long seed, const int maxIterNoImpr, const int maxIterSeconds) {
    // Initialize the PRGN using the seed.
    m_prng.seed(seed);
+   m_relaxationTried = false;
+   m_relaxationSolved = false;
 
    Timer timer;
    timer.start();
+   const auto tStart = chrono::steady_clock::now();
    double timeBest = 0.0;
 
    m_model.timeLimit(maxIterSeconds);
    int itersWoImpr = 0;
    double currentObj = m_model.objValue();
 
-   for (int iter = 1;; ++iter) {
+   // Routes of the incumbent, to go back to when a subproblem fails.
+   vector <vector <pair<int, int>>> incumbent = m_model.routes();
+
+   // Elapsed time of the interrupted run, when resuming it.
+   double offset = 0.0;
+   int firstIter = 1;
+
+   m_trajectory.clear();
+   if (m_resume) {
+      istringstream(m_resume->prngState) >> m_prng;
+      itersWoImpr = m_resume->itersWoImpr;
+      timeBest = m_resume->timeBest;
+      offset = m_resume->elapsed;
+      firstIter = m_resume->iter + 1;
+      m_trajectory = m_resume->trajectory;
+      m_resume = nullptr;
+   } else {
+      m_trajectory.push_back(IncumbentPoint{0.0, currentObj, 0, "initial"});
+   }
+
+   using Clock = chrono::steady_clock;
+   auto secs = [] (Clock::time_point a, Clock::time_point b) {
+      return chrono::duration<double>(b - a).count();
+   };
+   Clock::time_point tCheckpoint = Clock::now();
+   Clock::time_point tArchive = Clock::now();
+   bool archivePending = false;
+
+   if (m_bounder)
+      m_bounder->offerIncumbent(currentObj);
+
+   // Incumbent of the last reduced-cost fixing pass.
+   double rcFixObj = numeric_limits<double>::infinity();
+
+   // Tardiness bound set by the last propagation.
+   double tardinessBound = numeric_limits<double>::infinity();
+
+   int numIters = firstIter - 1;
+   for (int iter = firstIter;; ++iter) {
+      const Clock::time_point tIter = Clock::now();
+      numIters = iter;
+
+      if (m_timeBudget > 0.0) {
+         const double remaining = m_timeBudget - offset - secs(tStart, tIter);
+         m_model.timeLimit(max(1, min(maxIterSeconds, int(ceil(remaining)))));
+      }
+
+      // Solved before the selection, while the current solution is readable.
+      const bool rcFixing = m_reducedCostFixing && currentObj < rcFixObj - 1e-6 && relaxationReady();
+
       chooseDecomp();
       selectDecompVehicles();
+      applyFocus();
+      selectTimingTiers();
 
-      m_model.fixCurrentSolution();
+      // The cut is oriented by the current solution, which is only readable
+      // before the model changes.
+      const bool symmetric = m_symmetryBreaking && m_vehiDecomp.size() == 2 &&
+         m_inst.vehicleClass(m_vehiDecomp[0]) == m_inst.vehicleClass(m_vehiDecomp[1]);
+      if (symmetric && m_model.firstVisit(m_vehiDecomp[0]) < m_model.firstVisit(m_vehiDecomp[1]))
+         swap(m_vehiDecomp[0], m_vehiDecomp[1]);
+      const Clock::time_point tSelect = Clock::now();
 
-      m_model.unfixVehicleSolution(m_vehiDecomp[0]);
-      m_model.unfixVehicleSolution(m_vehiDecomp[1]);
+      m_model.fixCurrentSolution(m_timeFixed);
+      if (rcFixing) {
+         const int arcsRemoved = m_model.removeArcsByReducedCost(currentObj);
+         rcFixObj = currentObj;
+         if (m_verbose && arcsRemoved > 0)
+            cout << "Reduced-cost fixing: " << arcsRemoved << " arcs removed, " << m_model.numActiveArcs() <<
+               " active." << endl;
+      }
+      if (m_boundPropagation) {
+         const double zMax = m_model.propagateIncumbent(currentObj);
+         if (m_verbose && zMax < tardinessBound)
+            cout << "Bound propagation: tardiness at most " << zMax << "." << endl;
+         tardinessBound = zMax;
+      }
+      const Clock::time_point tFix = Clock::now();
 
-      double newObj = m_model.solve();
+      if (m_currentDecomp == DecompMethod::VISITS)
+         m_model.unfixArcsAmong(m_freeNodes);
+      for (int v: m_vehiDecomp)
+         m_model.unfixVehicleSolution(v);
+      if (symmetric)
+         m_model.setSymmetryCut(m_vehiDecomp[0], m_vehiDecomp[1]);
+      else if (m_symmetryBreaking)
+         m_model.clearSymmetryCut();
+      const Clock::time_point tUnfix = Clock::now();
+
+      double newObj = currentObj;
+      if (m_model.trySolve()) {
+         newObj = m_model.objValue();
+         if (newObj < currentObj - 1e-6) {
+            incumbent = m_model.routes();
+            archivePending = true;
+         }
+      } else {
+         if (m_verbose)
+            cout << "Subproblem found no solution; restoring the incumbent." << endl;
+         restoreIncumbent(incumbent);
+         // The arcs removed by reduced-cost fixing are back; remove them again.
+         rcFixObj = numeric_limits<double>::infinity();
+      }
+      const Clock::time_point tSolve = Clock::now();
 
       timer.finish();
-      cout << "Iteration: " << iter << "  Decomp: " << m_currentDecompName <<
-         "  Elapsed: " << fixed << setprecision(1) << timer.elapsed() << " secs  Obj: " << newObj << "  Improved: " <<
-         (currentObj/newObj - 1.0) * 100 << "%  IWoI: " << itersWoImpr << endl;
+      if (newObj < m_trajectory.back().obj - 1e-6)
+         m_trajectory.push_back(IncumbentPoint{offset + timer.elapsed(), newObj, iter, m_currentDecompName});
 
+      if (m_verbose)
+         cout << "Iteration: " << iter << "  Decomp: " << m_currentDecompName <<
+            "  Elapsed: " << fixed << setprecision(1) << offset + timer.elapsed() << " secs  Obj: " << newObj << "  Improved: " <<
+            (currentObj/newObj - 1.0) * 100 << "%  IWoI: " << itersWoImpr << endl;
+
+      bool stop = false;
       if (currentObj - newObj > 0.5) {
          itersWoImpr = 0;
-         timeBest = timer.elapsed();
+         timeBest = offset + timer.elapsed();
       } else {
          ++itersWoImpr;
-         if (itersWoImpr >= maxIterNoImpr) {
-            break;
+         stop = itersWoImpr >= maxIterNoImpr;
+      }
+      if (m_timeBudget > 0.0 && offset + secs(tStart, Clock::now()) >= m_timeBudget)
+         stop = true;
+
+      if (m_bounder) {
+         m_bounder->offerIncumbent(newObj);
+         const double lb = m_bounder->bound();
+         if (newObj - lb <= m_stopGap * fabs(newObj) + 1e-6) {
+            if (m_verbose && !stop)
+               cout << "Gap to the lower bound " << lb << " closed; stopping." << endl;
+            stop = true;
          }
       }
 
+      if (m_progress)
+         m_progress(iter, offset + timer.elapsed(), newObj);
+
       currentObj = newObj;
+
+      if (m_trace) {
+         const MipModel::SolveStats &stats = m_model.lastSolve();
+         const Clock::time_point tEnd = Clock::now();
+         ostringstream line;
+         line << setprecision(6) << "{\"instance\": \"" << jsonEscape(m_inst.fileName()) << "\", \"seed\": " << seed <<
+            ", \"iter\": " << iter << ", \"decomp\": \"" << m_currentDecompName << "\"" <<
+            ", \"vehicles\": [";
+         for (size_t k = 0; k < m_vehiDecomp.size(); ++k)
+            line << (k ? ", " : "") << m_vehiDecomp[k];
+         line << "]" <<
+            ", \"partners\": [";
+         for (size_t k = 0; k < m_partners.size(); ++k)
+            line << (k ? ", " : "") << m_partners[k];
+         line << "]" <<
+            ", \"visits\": [";
+         for (size_t k = 0; k < m_visitDecomp.size(); ++k)
+            line << (k ? ", " : "") << m_visitDecomp[k];
+         line << "]" <<
+            ", \"symmetric\": " << (symmetric ? "true" : "false") <<
+            ", \"active_arcs\": " << m_model.numActiveArcs() <<
+            ", \"t_select\": " << secs(tIter, tSelect) <<
+            ", \"t_fix\": " << secs(tSelect, tFix) <<
+            ", \"t_unfix\": " << secs(tFix, tUnfix) <<
+            ", \"t_solve\": " << secs(tUnfix, tSolve) <<
+            ", \"t_other\": " << secs(tSolve, tEnd) <<
+            ", \"nodes\": " << stats.nodes <<
+            ", \"lp_iters\": " << stats.iterations <<
+            ", \"gap\": " << stats.gap <<
+            ", \"time_limit\": " << (stats.timeLimitHit ? "true" : "false") <<
+            ", \"obj\": " << setprecision(10) << newObj <<
+            ", \"elapsed\": " << offset + secs(tStart, tEnd) << "}";
+         m_trace->append(line.str());
+      }
+
+      if (m_archive && archivePending && secs(tArchive, Clock::now()) >= m_archiveInterval) {
+         if (m_archive->offer(m_inst, currentObj, incumbent) && m_verbose)
+            cout << "Incumbent " << currentObj << " stored in the archive." << endl;
+         archivePending = false;
+         tArchive = Clock::now();
+      }
+
+      if (!m_checkpointPath.empty() && !stop && secs(tCheckpoint, Clock::now()) >= m_checkpointInterval) {
+         Checkpoint cp;
+         cp.instanceHash = m_inst.contentHash();
+         cp.seed = seed;
+         cp.iter = iter;
+         cp.itersWoImpr = itersWoImpr;
+         cp.obj = currentObj;
+         cp.timeBest = timeBest;
+         cp.elapsed = offset + secs(tStart, Clock::now());
+         ostringstream prngState;
+         prngState << m_prng;
+         cp.prngState = prngState.str();
+         cp.trajectory = m_trajectory;
+         cp.routes = m_model.routes();
+         cp.write(m_checkpointPath, m_inst);
+         tCheckpoint = Clock::now();
+      }
+
+      if (stop)
+         break;
    }
 
    timer.finish();
 
    m_model.fixCurrentSolution();
-   m_model.solve();
-
-   // Registers the solution into a CSV file.
-   ofstream csv("results-fixAndOptimize.csv", ios::out | ios::app);
-
-   // Write the header if the file is created in this run.
-   if (csv.tellp() == 0) {
-      csv <<
-         "instance," <<
-         "seed," <<
-         "time.best," <<
-         "time.total," <<
-         "cost" <<
-      endl;
-   }
+   m_model.clearSymmetryCut();
+   if (!m_model.trySolve())
+      restoreIncumbent(incumbent);
+
+   m_timeBest = timeBest;
+   m_timeTotal = offset + timer.elapsed();
+   m_trajectory.push_back(IncumbentPoint{m_timeTotal, m_model.objValue(), numIters, "end"});
+}
+
+void FixAndOptimize::restoreIncumbent(const vector <vector <pair<int, int>>> &routes) {
+   m_model.unfixSolution();
+   m_model.clearSymmetryCut();
+   m_model.setRoutes(routes);
+   if (!m_model.trySolve())
+      throw runtime_error("FixAndOptimize: the incumbent could not be restored.");
+}
+
+void FixAndOptimize::setVerbose(bool toggle) {
+   m_verbose = toggle;
+}
+
+void FixAndOptimize::setTrace(TraceLog *trace) {
+   m_trace = trace;
+}
+
+void FixAndOptimize::setProgress(ProgressCallback progress) {
+   m_progress = progress;
+}
+
+void FixAndOptimize::setTimeBudget(double seconds) {
+   m_timeBudget = seconds;
+}
+
+void FixAndOptimize::setFocus(const vector <int> &vehicles) {
+   m_focus = vehicles;
+}
+
+void FixAndOptimize::setSymmetryBreaking(bool toggle) {
+   m_symmetryBreaking = toggle;
+}
+
+void FixAndOptimize::setDecompositions(const vector <DecompMethod> &methods) {
+   if (!methods.empty())
+      m_decomps = methods;
+}
+
+void FixAndOptimize::setReducedCostFixing(bool toggle) {
+   m_reducedCostFixing = toggle;
+}
+
+void FixAndOptimize::setBoundPropagation(bool toggle) {
+   m_boundPropagation = toggle;
+}
+
+void FixAndOptimize::setPartnerTiming(bool toggle) {
+   m_partnerTiming = toggle;
+}
+
+void FixAndOptimize::setLowerBounder(LowerBounder *bounder, double stopGap) {
+   m_bounder = bounder;
+   m_stopGap = stopGap;
+}
 
-   csv <<
-      m_inst.fileName() << "," <<
-      seed << "," <<
-      timeBest << "," <<
-      timer.elapsed() << "," <<
-      m_model.objValue() <<
-   endl;
+void FixAndOptimize::setCheckpoint(const string &path, double intervalSeconds) {
+   m_checkpointPath = path;
+   m_checkpointInterval = intervalSeconds;
+}
+
+void FixAndOptimize::setArchive(SolutionArchive *archive, double intervalSeconds) {
+   m_archive = archive;
+   m_archiveInterval = intervalSeconds;
+}
+
+void FixAndOptimize::setResume(const Checkpoint *checkpoint) {
+   m_resume = checkpoint;
+}
+
+double FixAndOptimize::timeBest() const {
+   return m_timeBest;
+}
+
+double FixAndOptimize::timeTotal() const {
+   return m_timeTotal;
+}
+
+const vector <IncumbentPoint> &FixAndOptimize::trajectory() const {
+   return m_trajectory;
 }
 
 void FixAndOptimize::chooseDecomp() {
-   uniform_int_distribution <int> decDistr(0, (int) DecompMethod::MAX_-1);
-   m_currentDecomp = (DecompMethod) decDistr(m_prng);
+   uniform_int_distribution <int> decDistr(0, int(m_decomps.size())-1);
+   m_currentDecomp = m_decomps[decDistr(m_prng)];
 }
 
 void FixAndOptimize::selectDecompVehicles() {
-   if (m_currentDecomp == DecompMethod::RANDOM) {
+   m_visitDecomp.clear();
+   m_freeNodes.clear();
+   m_vehiDecomp.assign(2, -1);
+
+   if (m_currentDecomp == DecompMethod::VISITS) {
+      m_currentDecompName = "visits";
+      m_vehiDecomp.clear();
+      selectDecompVisits();
+
+   } else if (m_currentDecomp == DecompMethod::SYNC && selectDecompCoupled()) {
+      m_currentDecompName = "sync";
+
+   } else if (m_currentDecomp == DecompMethod::TARDY && selectDecompTardy()) {
+      m_currentDecompName = "tardy";
+
+   } else if (m_currentDecomp == DecompMethod::RANDOM || m_currentDecomp == DecompMethod::SYNC) {
+      // Also the fallback of SYNC, when no vehicles are coupled.
       m_currentDecompName = "random";
       uniform_int_distribution <int> vdistr(0, m_inst.numVehicles()-1);
 
@@ -127,7 +420,27 @@ void FixAndOptimize::selectDecompVehicles() {
          m_vehiDecomp[1] = vdistr(m_prng);
       } while (m_vehiDecomp[0] == m_vehiDecomp[1]);
 
+   } else if (m_currentDecomp == DecompMethod::LP_GUIDED && relaxationReady()) {
+      m_currentDecompName = "lp";
+
+      // Choose two vehicles among the 50% farthest from the relaxation.
+      const vector <double> dist = m_model.relaxationDistances();
+      vector <int> vehicles(m_inst.numVehicles());
+      iota(vehicles.begin(), vehicles.end(), 0);
+      sort(vehicles.begin(), vehicles.end(), [&dist] (int a, int b) {
+         return dist[a] > dist[b];
+      });
+
+      const int cutoff = max(2, (m_inst.numVehicles() + 1) / 2);
+      uniform_int_distribution <int> chooser(0, cutoff-1);
+      m_vehiDecomp[0] = vehicles[chooser(m_prng)];
+      do {
+         m_vehiDecomp[1] = vehicles[chooser(m_prng)];
+      } while (m_vehiDecomp[0] == m_vehiDecomp[1]);
+
    } else {
+      // Also the fallback of LP_GUIDED, when the relaxation can not be
+      // solved, and of TARDY, when no visit is tardy.
       m_currentDecompName = "guided";
 
       // Get the service start time for each service and service type requested.
@@ -163,3 +476,214 @@ void FixAndOptimize::selectDecompVehicles() {
    }
 }
 
+void FixAndOptimize::selectDecompVisits() {
+   const vector <vector <pair<int, int>>> routes = m_model.routes();
+
+   // Patients that can seed the region: any visited one, or, with a focus,
+   // the ones visited by focused vehicles.
+   vector <char> visited(m_inst.numNodes(), 0), seedable(m_inst.numNodes(), 0);
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      const bool focused = m_focus.empty() || find(m_focus.begin(), m_focus.end(), v) != m_focus.end();
+      for (const pair<int, int> &visit: routes[v]) {
+         visited[visit.first] = 1;
+         seedable[visit.first] |= focused;
+      }
+   }
+   vector <int> seeds;
+   for (int i = 1; i < m_inst.numNodes()-1; ++i)
+      if (seedable[i])
+         seeds.push_back(i);
+   if (seeds.empty())
+      return;
+
+   uniform_int_distribution <int> sdistr(0, int(seeds.size())-1);
+   const int seed = seeds[sdistr(m_prng)];
+
+   // Related patients: close to the seed, and with similar time windows.
+   vector <int> patients;
+   for (int i = 1; i < m_inst.numNodes()-1; ++i)
+      if (visited[i] && i != seed)
+         patients.push_back(i);
+   auto relatedness = [&] (int i) {
+      return m_inst.distance(seed, i) + fabs(m_inst.nodeTwMin(seed) - m_inst.nodeTwMin(i));
+   };
+   const int size = min(regionSize - 1, int(patients.size()));
+   partial_sort(patients.begin(), patients.begin() + size, patients.end(), [&] (int a, int b) {
+      return relatedness(a) < relatedness(b);
+   });
+   m_visitDecomp.push_back(seed);
+   m_visitDecomp.insert(m_visitDecomp.end(), patients.begin(), patients.begin() + size);
+
+   // The neighbors of the region in the routes are freed too, so its
+   // patients can be removed from them, or inserted between them.
+   vector <char> inRegion(m_inst.numNodes(), 0);
+   for (int i: m_visitDecomp)
+      inRegion[i] = 1;
+   m_freeNodes = m_visitDecomp;
+   for (const auto &route: routes) {
+      for (size_t k = 0; k < route.size(); ++k) {
+         if (!inRegion[route[k].first])
+            continue;
+         if (k > 0)
+            m_freeNodes.push_back(route[k-1].first);
+         if (k+1 < route.size())
+            m_freeNodes.push_back(route[k+1].first);
+      }
+   }
+}
+
+bool FixAndOptimize::selectDecompCoupled() {
+   const int nv = m_inst.numVehicles();
+   const vector <vector <pair<int, int>>> routes = m_model.routes();
+
+   // Coupling graph: number of nodes shared by each pair of vehicles.
+   vector <vector <int>> visitors(m_inst.numNodes());
+   for (int v = 0; v < nv; ++v)
+      for (const pair<int, int> &visit: routes[v])
+         visitors[visit.first].push_back(v);
+   vector <vector <int>> shared(nv, vector <int>(nv, 0));
+   for (const vector <int> &vs: visitors)
+      for (size_t a = 0; a < vs.size(); ++a)
+         for (size_t b = 0; b < vs.size(); ++b)
+            if (vs[a] != vs[b])
+               ++shared[vs[a]][vs[b]];
+
+   vector <int> coupled;
+   for (int v = 0; v < nv; ++v)
+      if (any_of(shared[v].begin(), shared[v].end(), [] (int n) { return n > 0; }))
+         coupled.push_back(v);
+   if (coupled.empty())
+      return false;
+
+   uniform_int_distribution <int> cdistr(0, int(coupled.size())-1);
+   const int root = coupled[cdistr(m_prng)];
+
+   // Grows the set from the root, always adding the vehicle most coupled
+   // to it; with a small component, this frees the whole component.
+   m_vehiDecomp.assign(1, root);
+   while (int(m_vehiDecomp.size()) < maxCoupledVehicles) {
+      int best = -1, bestShared = 0;
+      for (int w = 0; w < nv; ++w) {
+         if (find(m_vehiDecomp.begin(), m_vehiDecomp.end(), w) != m_vehiDecomp.end())
+            continue;
+         int n = 0;
+         for (int v: m_vehiDecomp)
+            n += shared[v][w];
+         if (n > bestShared) {
+            best = w;
+            bestShared = n;
+         }
+      }
+      if (best == -1)
+         break;
+      m_vehiDecomp.push_back(best);
+   }
+   return true;
+}
+
+void FixAndOptimize::selectTimingTiers() {
+   m_partners.clear();
+   m_timeFixed.clear();
+   if (!m_partnerTiming || m_vehiDecomp.empty())
+      return;
+
+   // 0: fixed, 1: partner, 2: freed.
+   vector <int> tier(m_inst.numVehicles(), 0);
+   for (int v: m_vehiDecomp)
+      tier[v] = 2;
+
+   const vector <vector <pair<int, int>>> routes = m_model.routes();
+   vector <char> freedNode(m_inst.numNodes(), 0);
+   for (int v: m_vehiDecomp)
+      for (const pair<int, int> &visit: routes[v])
+         freedNode[visit.first] = 1;
+   for (int v = 0; v < m_inst.numVehicles(); ++v)
+      for (const pair<int, int> &visit: routes[v])
+         if (tier[v] == 0 && freedNode[visit.first])
+            tier[v] = 1;
+
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      if (tier[v] == 1)
+         m_partners.push_back(v);
+      else if (tier[v] == 0)
+         m_timeFixed.push_back(v);
+   }
+}
+
+bool FixAndOptimize::selectDecompTardy() {
+   const vector <vector <pair<int, int>>> routes = m_model.routes();
+
+   // The most tardy visit (the one defining Tmax), and the vehicles at each
+   // node.
+   double worst = 1e-6;
+   int node = -1, skill = -1;
+   vector <vector <int>> visitors(m_inst.numNodes());
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      for (const pair<int, int> &visit: routes[v]) {
+         visitors[visit.first].push_back(v);
+         const double z = m_model.tardiness(visit.first, visit.second);
+         if (z > worst) {
+            worst = z;
+            node = visit.first;
+            skill = visit.second;
+         }
+      }
+   }
+   if (node == -1)
+      return false;
+
+   // Frees the vehicles at the node (both, for double services), and one of
+   // the vehicles with the skill whose routes pass closest to it.
+   m_vehiDecomp = visitors[node];
+   vector <pair<double, int>> receivers;
+   for (int w = 0; w < m_inst.numVehicles(); ++w) {
+      if (!m_inst.vehicleHasSkill(w, skill) || find(m_vehiDecomp.begin(), m_vehiDecomp.end(), w) != m_vehiDecomp.end())
+         continue;
+      double dist = m_inst.distance(0, node);
+      for (const pair<int, int> &visit: routes[w])
+         dist = min(dist, m_inst.distance(visit.first, node));
+      receivers.push_back(make_pair(dist, w));
+   }
+   if (!receivers.empty()) {
+      sort(receivers.begin(), receivers.end());
+      uniform_int_distribution <int> rdistr(0, min(receiverCandidates, int(receivers.size()))-1);
+      m_vehiDecomp.push_back(receivers[rdistr(m_prng)].second);
+   }
+   return true;
+}
+
+bool FixAndOptimize::relaxationReady() {
+   if (m_model.hasRelaxation())
+      return true;
+
+   // The model drops the relaxation when it changes; it is solved again then.
+   const bool resolve = m_relaxationSolved;
+   if (resolve) {
+      m_relaxationSolved = false;
+      m_relaxationTried = false;
+   }
+
+   if (!m_relaxationTried) {
+      m_relaxationTried = true;
+      m_relaxationSolved = m_model.solveRelaxation();
+      if (!m_relaxationSolved && m_verbose)
+         cout << "LP relaxation could not be solved" << (resolve ? " again after a model change" : "") <<
+            "; using the guided decomposition instead of \"lp\" from now on." << endl;
+   }
+   return m_relaxationSolved;
+}
+
+void FixAndOptimize::applyFocus() {
+   // The VISITS decomposition applies the focus when choosing its region.
+   if (m_focus.empty() || m_currentDecomp == DecompMethod::VISITS)
+      return;
+
+   for (int v: m_vehiDecomp)
+      if (find(m_focus.begin(), m_focus.end(), v) != m_focus.end())
+         return;
+
+   // Replace one of the vehicles by a focused one (which differs from the
+   // others, since they are not focused).
+   uniform_int_distribution <int> fdistr(0, int(m_focus.size())-1);
+   m_vehiDecomp[0] = m_focus[fdistr(m_prng)];
+}
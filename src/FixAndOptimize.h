@@ -27,34 +27,247 @@
 
 #pragma once
 
+#include "Checkpoint.h"
+#include "LowerBounder.h"
 #include "MipModel.h"
+#include "ResultsLog.h"
+#include "SolutionArchive.h"
 
+#include <functional>
 #include <random>
+#include <vector>
 
 class FixAndOptimize {
 public:
 
+   /**
+    * Decompositions: which two vehicles each iteration frees.
+    * RANDOM: any two vehicles.
+    * GUIDED: vehicles with the latest service start times.
+    * LP_GUIDED: vehicles whose arcs differ the most from the LP relaxation
+    *    of the model (see `MipModel::relaxationDistances`).
+    * VISITS: instead of whole vehicles, a region of related patients (close
+    *    in space and in the start of their time windows to a random one):
+    *    the arcs among them and their neighbors in the routes are freed for
+    *    every vehicle, and the rest of every route stays fixed.
+    * SYNC: vehicles coupled by double services. In the coupling graph of the
+    *    current solution, vehicles are linked when they share a node; a
+    *    random coupled vehicle is freed with its connected component, or,
+    *    if that is too large, with its most strongly coupled partners.
+    * TARDY: vehicles serving the most tardy visit (the one defining Tmax),
+    *    with one of the vehicles closest to it among the ones with the skill
+    *    required, to receive it.
+    */
    enum class DecompMethod: int {
       RANDOM = 0,
       GUIDED = 1,
-      MAX_ = 2
+      LP_GUIDED = 2,
+      VISITS = 3,
+      SYNC = 4,
+      TARDY = 5,
+      MAX_ = 6
    };
 
+   static const char *decompName(DecompMethod method);
+
+   /**
+    * Parses a comma-separated list of decomposition names (e.g.
+    * "random,guided,lp"). Returns false if any name is unknown.
+    */
+   static bool parseDecompositions(const std::string &list, std::vector <DecompMethod> &methods);
+
    FixAndOptimize(MipModel &model);
    virtual ~FixAndOptimize();
 
-   void solve(const int seed, const int maxIterNoImpr, const int maxIterSeconds);
+   void solve(const long seed, const int maxIterNoImpr, const int maxIterSeconds);
+
+   /**
+    * Toggles the progress line printed at each iteration.
+    */
+   void setVerbose(bool toggle);
+
+   /**
+    * Writes one JSON line per iteration into `trace`, with the time spent in
+    * each phase (decomposition selection, fixing, unfixing, CPLEX solve and
+    * bookkeeping) and the statistics of the subproblem solve. `nullptr`
+    * disables the trace.
+    */
+   void setTrace(TraceLog *trace);
+
+   /**
+    * Called at the end of each iteration with the iteration number, the
+    * elapsed time (in seconds) and the objective value of the iteration.
+    */
+   using ProgressCallback = std::function <void(int iter, double elapsed, double obj)>;
+   void setProgress(ProgressCallback progress);
+
+   /**
+    * Wall-clock budget of `solve`, in seconds; the search stops once it is
+    * exhausted, and subproblems never exceed what remains of it. Non-positive
+    * values disable the budget.
+    */
+   void setTimeBudget(double seconds);
+
+   /**
+    * Restricts the search to decompositions that free at least one of
+    * `vehicles` (e.g., the vehicles affected by a change of the plan). An
+    * empty list removes the restriction.
+    */
+   void setFocus(const std::vector <int> &vehicles);
+
+   /**
+    * When both vehicles freed by a decomposition are interchangeable (see
+    * `Instance::vehicleClass`), orders them in the subproblem (see
+    * `MipModel::setSymmetryCut`), so equivalent permutations of their routes
+    * are not explored.
+    */
+   void setSymmetryBreaking(bool toggle);
+
+   /**
+    * Decompositions drawn, uniformly, at each iteration. Defaults to RANDOM
+    * and GUIDED.
+    */
+   void setDecompositions(const std::vector <DecompMethod> &methods);
+
+   /**
+    * Removes, whenever the incumbent improves, the arcs that can not be part
+    * of a better solution according to the reduced costs of the LP
+    * relaxation (see `MipModel::removeArcsByReducedCost`). Subproblems and
+    * fixing passes then only handle the remaining arcs.
+    */
+   void setReducedCostFixing(bool toggle);
+
+   /**
+    * Tightens the bounds of the tardiness and start time variables whenever
+    * the incumbent improves (see `MipModel::propagateIncumbent`), so the
+    * subproblems start with tighter big-M constraints.
+    */
+   void setBoundPropagation(bool toggle);
+
+   /**
+    * Three-tier subproblems: the freed vehicles may be rerouted, their
+    * synchronization partners (vehicles sharing a node with them) keep
+    * their routes but may be rescheduled, and every other vehicle keeps
+    * both its route and its start times (see
+    * `MipModel::fixCurrentSolution`). Has no effect on the VISITS
+    * decomposition, which frees no whole vehicles.
+    */
+   void setPartnerTiming(bool toggle);
+
+   /**
+    * Global lower bound of the instance, computed alongside the search (see
+    * `LowerBounder`), which receives every improving incumbent. The search
+    * stops once the relative gap between the incumbent and the bound is at
+    * most `stopGap`. `nullptr` disables it.
+    */
+   void setLowerBounder(LowerBounder *bounder, double stopGap);
+
+   /**
+    * Writes the state of the search into `path` at the end of iterations,
+    * at most once every `intervalSeconds`. An empty path disables it.
+    */
+   void setCheckpoint(const std::string &path, double intervalSeconds);
+
+   /**
+    * Offers improving incumbents to `archive` during the search, at most
+    * once every `intervalSeconds`; an improvement held back is offered at
+    * the end of a later iteration. `nullptr` disables it.
+    */
+   void setArchive(SolutionArchive *archive, double intervalSeconds);
 
-private:
+   /**
+    * Makes the next call to `solve` continue the run saved in `checkpoint`
+    * (PRNG state, counters, elapsed time and trajectory), instead of
+    * starting a new one. The model must hold the routes of the checkpoint.
+    */
+   void setResume(const Checkpoint *checkpoint);
+
+   /**
+    * Statistics of the last call to `solve`: elapsed time (in seconds) until
+    * the last improvement, and total elapsed time.
+    */
+   double timeBest() const;
+   double timeTotal() const;
+
+   /**
+    * Incumbent trajectory of the last call to `solve`: the initial solution,
+    * every improving solution, and a final point of type "end".
+    */
+   const std::vector <IncumbentPoint> &trajectory() const;
+
+protected:
    const Instance &m_inst;
    MipModel &m_model;
 
+   bool m_verbose;
+   TraceLog *m_trace;
+   ProgressCallback m_progress;
+   double m_timeBudget;
+   std::vector <int> m_focus;
+   bool m_symmetryBreaking;
+   std::vector <DecompMethod> m_decomps;
+   bool m_relaxationTried;
+   bool m_relaxationSolved;
+   bool m_reducedCostFixing;
+   bool m_boundPropagation;
+   bool m_partnerTiming;
+   LowerBounder *m_bounder;
+   double m_stopGap;
+
+   std::string m_checkpointPath;
+   double m_checkpointInterval;
+   SolutionArchive *m_archive;
+   double m_archiveInterval;
+   const Checkpoint *m_resume;
+   double m_timeBest;
+   double m_timeTotal;
+   std::vector <IncumbentPoint> m_trajectory;
+
    std::mt19937_64 m_prng;
 
    DecompMethod m_currentDecomp;
    std::string m_currentDecompName;
-   int m_vehiDecomp[2];
+   std::vector <int> m_vehiDecomp;
+
+   /** Patients of the VISITS decomposition, and the nodes whose arcs it frees. */
+   std::vector <int> m_visitDecomp;
+   std::vector <int> m_freeNodes;
+
+   /** Partners of the freed vehicles, and vehicles whose start times are fixed (see `setPartnerTiming`). */
+   std::vector <int> m_partners;
+   std::vector <int> m_timeFixed;
+
+   /** Size of the region of the VISITS decomposition. */
+   constexpr static int regionSize = 8;
+
+   /** Maximum number of vehicles freed by the SYNC decomposition. */
+   constexpr static int maxCoupledVehicles = 3;
+
+   /** Number of the closest vehicles the TARDY decomposition chooses the receiver from. */
+   constexpr static int receiverCandidates = 3;
 
    void chooseDecomp();
    void selectDecompVehicles();
+   void selectDecompVisits();
+
+   /** Returns false if no vehicles are coupled. */
+   bool selectDecompCoupled();
+
+   /** Returns false if no visit is tardy. */
+   bool selectDecompTardy();
+   void applyFocus();
+   void selectTimingTiers();
+
+   /**
+    * Frees the model and fixes it back to the given routes. Throws
+    * `std::runtime_error` if they can not be solved anymore.
+    */
+   void restoreIncumbent(const std::vector <std::vector <std::pair<int, int>>> &routes);
+
+   /**
+    * Whether the LP relaxation is available; it is solved on the first call
+    * of each run that needs it, and again after the model drops it, but not
+    * retried if that fails.
+    */
+   bool relaxationReady();
 };
@@ -28,9 +28,11 @@
 #include "InitialRouting.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <numeric> //iota
 
 
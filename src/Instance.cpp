@@ -26,50 +26,304 @@
  */
 
 #include "Instance.h"
+#include "MappedFile.h"
+
 #include <limits>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <numeric> // std::accumulate
+#include <stdexcept>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
-Instance::Instance(const char* fname) {
+namespace {
+
+/**
+ * Cursor over the text of an instance file.
+ * Numbers are scanned in place, without copying or tokenizing the lines.
+ */
+class TextScanner {
+public:
+   TextScanner(const char *begin, const char *end): m_pos(begin), m_end(end) {
+      // Empty
+   }
+
+   /**
+    * Gets the next line as [first, last), without line break and trailing
+    * blanks. Returns false at the end of the text.
+    */
+   bool nextLine(const char *&first, const char *&last) {
+      if (m_pos >= m_end)
+         return false;
+      first = m_pos;
+      const char *nl = static_cast<const char *>(std::memchr(m_pos, '\n', size_t(m_end - m_pos)));
+      last = nl ? nl : m_end;
+      m_pos = nl ? nl + 1 : m_end;
+      while (first < last && isBlank(*first))
+         ++first;
+      while (last > first && isBlank(*(last-1)))
+         --last;
+      return true;
+   }
+
+   void skipLine() {
+      const char *first, *last;
+      nextLine(first, last);
+   }
+
+   /**
+    * Reads the next integer, skipping any whitespace (line breaks included)
+    * before it, just as `operator>>` of streams.
+    */
+   bool readInt(int &value) {
+      skipSpaces();
+      const char *p = m_pos;
+      bool neg = false;
+      if (p < m_end && (*p == '-' || *p == '+'))
+         neg = *p++ == '-';
+      if (p >= m_end || !isDigit(*p))
+         return false;
+      long acc = 0;
+      while (p < m_end && isDigit(*p))
+         acc = acc * 10 + (*p++ - '0');
+      value = int(neg ? -acc : acc);
+      m_pos = p;
+      return true;
+   }
+
+   /**
+    * Reads the next floating point number. Numbers with up to 19 significant
+    * digits and small exponents are converted exactly by a single
+    * multiplication or division by a power of ten; anything else falls back
+    * to `strtod`.
+    */
+   bool readDouble(double &value) {
+      static const double pow10[] = {
+         1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+
+      skipSpaces();
+      const char *p = m_pos;
+      bool neg = false;
+      if (p < m_end && (*p == '-' || *p == '+'))
+         neg = *p++ == '-';
+
+      uint64_t mant = 0;
+      int ndigits = 0, exp10 = 0;
+      bool exact = true;
+      while (p < m_end && isDigit(*p)) {
+         if (mant < 100000000000000000ull)
+            mant = mant * 10 + uint64_t(*p - '0');
+         else
+            exact = false;
+         ++p;
+         ++ndigits;
+      }
+      if (p < m_end && *p == '.') {
+         ++p;
+         while (p < m_end && isDigit(*p)) {
+            if (mant < 100000000000000000ull) {
+               mant = mant * 10 + uint64_t(*p - '0');
+               --exp10;
+            } else {
+               exact = false;
+            }
+            ++p;
+            ++ndigits;
+         }
+      }
+      if (ndigits > 0 && p < m_end && (*p == 'e' || *p == 'E')) {
+         const char *q = p + 1;
+         bool eneg = false;
+         if (q < m_end && (*q == '-' || *q == '+'))
+            eneg = *q++ == '-';
+         if (q < m_end && isDigit(*q)) {
+            int e = 0;
+            while (q < m_end && isDigit(*q)) {
+               if (e < 10000)
+                  e = e * 10 + (*q - '0');
+               ++q;
+            }
+            exp10 += eneg ? -e : e;
+            p = q;
+         }
+      }
+
+      if (ndigits > 0 && exact && mant <= (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+         double v = double(mant);
+         v = exp10 < 0 ? v / pow10[-exp10] : v * pow10[exp10];
+         value = neg ? -v : v;
+         m_pos = p;
+         return true;
+      }
+      return readDoubleSlow(value);
+   }
+
+private:
+   const char *m_pos;
+   const char *m_end;
+
+   static bool isDigit(char c) {
+      return c >= '0' && c <= '9';
+   }
+
+   static bool isBlank(char c) {
+      return c == ' ' || c == '\t' || c == '\r';
+   }
+
+   static bool isSpace(char c) {
+      return isBlank(c) || c == '\n' || c == '\v' || c == '\f';
+   }
+
+   void skipSpaces() {
+      while (m_pos < m_end && isSpace(*m_pos))
+         ++m_pos;
+   }
+
+   bool readDoubleSlow(double &value) {
+      const char *tokEnd = m_pos;
+      while (tokEnd < m_end && !isSpace(*tokEnd))
+         ++tokEnd;
+
+      char buf[64];
+      size_t len = size_t(tokEnd - m_pos);
+      if (len == 0 || len >= sizeof buf)
+         return false;
+      std::memcpy(buf, m_pos, len);
+      buf[len] = '\0';
+
+      char *parsed = nullptr;
+      value = std::strtod(buf, &parsed);
+      if (parsed == buf)
+         return false;
+      m_pos += parsed - buf;
+      return true;
+   }
+};
+
+/**
+ * Header of binary instance caches. It is followed by the flat arrays
+ * written by `Instance::serialize`.
+ */
+struct CacheHeader {
+   char magic[8];
+   uint32_t version;
+   int32_t numNodes;
+   int32_t numVehicles;
+   int32_t numSkills;
+   uint64_t srcSize;
+   int64_t srcMtime;
+   uint64_t payloadSize;
+   uint64_t checksum;
+};
+
+const char cacheMagic[8] = {'H', 'H', 'C', 'R', 'S', 'P', 'I', 'C'};
+const uint32_t cacheVersion = 1;
+
+bool lineIs(const char *first, const char *last, const char *token) {
+   const size_t len = std::strlen(token);
+   return size_t(last - first) == len && std::memcmp(first, token, len) == 0;
+}
+
+} // anonymous namespace
+
+const char *Instance::distanceModeName(DistanceMode mode) {
+   switch (mode) {
+      case DistanceMode::FULL: return "full";
+      case DistanceMode::SYMMETRIC: return "symmetric";
+      case DistanceMode::FLOAT32: return "float32";
+      case DistanceMode::EUCLIDEAN: return "euclidean";
+      default: return "unknown";
+   }
+}
+
+bool Instance::parseDistanceMode(const char *name, DistanceMode &mode) {
+   for (int m = 0; m < (int) DistanceMode::MAX_; ++m) {
+      if (std::string(name) == distanceModeName((DistanceMode) m)) {
+         mode = (DistanceMode) m;
+         return true;
+      }
+   }
+   return false;
+}
+
+Instance::Instance(const char* fname, DistanceMode distMode, bool useCache): m_numNodes(0), m_numVehicles(0),
+   m_numSkills(0) {
    m_fname = fname;
-   std::ifstream fid(fname);
-   if (!fid) {
-      std::cout << "Instance file " << fname << " could not be read." << std::endl;
-      std::exit(EXIT_FAILURE);
+
+   std::vector <double> dist;
+   const std::string cache = cachePath(fname);
+   if (!useCache || !readCache(cache, dist)) {
+      readText(dist);
+
+      std::vector <char> payload;
+      serialize(dist, payload);
+      m_hash = hashBytes(payload.data(), payload.size());
+      if (useCache)
+         writeCache(cache, payload);
    }
 
+   setupDistances(dist, distMode);
+   setupVehicleClasses();
+}
+
+void Instance::readText(std::vector <double> &dist) {
+   const char *fname = m_fname.c_str();
+   MappedFile file(fname);
+   if (!file.isOpen())
+      throw std::runtime_error(std::string("Instance file ") + fname + " could not be read.");
+
    std::vector <int> dscheck;
-   std::string buf, lastenv;
-   while (std::getline(fid, buf)) {
-      if (buf.length() == 0 || buf.find_first_not_of(" ") == std::string::npos) {
+   std::string lastenv;
+
+   TextScanner fid(file.data(), file.data() + file.size());
+   auto fail = [&] () {
+      throw std::runtime_error("Malformed number in section " + lastenv + " of instance " + fname + ".");
+   };
+
+   const char *first, *last;
+   while (fid.nextLine(first, last)) {
+      if (first == last) {
          // Skip empty lines
-      } else if (buf == "nbNodes") {
-         lastenv = buf;
-         fid >> m_numNodes;
-      } else if (buf == "nbVehi") {
-         lastenv = buf;
-         fid >> m_numVehicles;
-      } else if (buf == "nbServi") {
-         lastenv = buf;
-         fid >> m_numSkills;
+      } else if (lineIs(first, last, "nbNodes")) {
+         lastenv = "nbNodes";
+         if (!fid.readInt(m_numNodes) || m_numNodes < 2) fail();
+      } else if (lineIs(first, last, "nbVehi")) {
+         lastenv = "nbVehi";
+         if (!fid.readInt(m_numVehicles) || m_numVehicles < 1) fail();
+      } else if (lineIs(first, last, "nbServi")) {
+         lastenv = "nbServi";
+         if (!fid.readInt(m_numSkills) || m_numSkills < 1) fail();
          resize();
-      } else if (buf == "r") {
-         lastenv = buf;
-         for (auto &i: m_nodeReqSkills)
-            for (auto &s: i)
-               fid >> s;
-      } else if (buf == "DS") {
-         lastenv = buf;
-         std::getline(fid, buf);
-         std::stringstream stream(buf);
-         int id;
-         while (stream >> id) {
-            dscheck.push_back(id-1);
+      } else if (lineIs(first, last, "r")) {
+         lastenv = "r";
+         for (auto &s: m_nodeReqSkills)
+            if (!fid.readInt(s)) fail();
+      } else if (lineIs(first, last, "DS")) {
+         lastenv = "DS";
+         if (m_nodeReqSkills.size() != size_t(m_numNodes) * m_numSkills)
+            throw std::runtime_error("Section DS precedes the sizes of instance " + m_fname + ".");
+         if (fid.nextLine(first, last)) {
+            TextScanner stream(first, last);
+            int id;
+            while (stream.readInt(id)) {
+               if (id < 2 || id > m_numNodes-1)
+                  throw std::runtime_error("Double service node " + std::to_string(id) + " out of range in instance " +
+                     fname + ".");
+               dscheck.push_back(id-1);
+            }
          }
          for (int i = 1; i < m_numNodes-1; ++i) {
             if (std::find(dscheck.begin(), dscheck.end(), i) != dscheck.end()) {
@@ -77,76 +331,74 @@ Instance::Instance(const char* fname) {
             }
             m_nodeSvcType[i] = SvcType::SINGLE;
 
-            int sksum = std::accumulate(m_nodeReqSkills[i].begin(), m_nodeReqSkills[i].end(), 0);
-            if (sksum != 1) {
-               std::cout << "Single service node " << i << " requiring a invalid amount of "
-                  << sksum << " service types." << std::endl;
-               std::abort();
-            }
+            int sksum = std::accumulate(&m_nodeReqSkills[i * m_numSkills], &m_nodeReqSkills[(i+1) * m_numSkills], 0);
+            if (sksum != 1)
+               throw std::runtime_error("Single service node " + std::to_string(i) + " requiring a invalid amount of " +
+                  std::to_string(sksum) + " service types.");
          }
-      } else if (buf == "a") {
-         lastenv = buf;
-         for (auto &v: m_vehicleSkills)
-            for (auto &s: v)
-               fid >> s;
-      } else if (buf == "x") {
-         lastenv = buf;
-         for (int i = 0; i < m_numNodes; ++i)
-            fid >> std::get<0>(m_nodePos[i]);
-      } else if (buf == "y") {
-         lastenv = buf;
+      } else if (lineIs(first, last, "a")) {
+         lastenv = "a";
+         for (auto &s: m_vehicleSkills)
+            if (!fid.readInt(s)) fail();
+      } else if (lineIs(first, last, "x")) {
+         lastenv = "x";
          for (int i = 0; i < m_numNodes; ++i)
-            fid >> std::get<1>(m_nodePos[i]);
-      } else if (buf == "d") {
-         lastenv = buf;
+            if (!fid.readDouble(m_nodePosX[i])) fail();
+      } else if (lineIs(first, last, "y")) {
+         lastenv = "y";
          for (int i = 0; i < m_numNodes; ++i)
-            for (int j = 0; j < m_numNodes; ++j)
-               fid >> m_distances[i][j];
-      } else if (buf == "p") {
-         lastenv = buf;
+            if (!fid.readDouble(m_nodePosY[i])) fail();
+      } else if (lineIs(first, last, "d")) {
+         lastenv = "d";
+         dist.resize(m_numNodes * m_numNodes);
+         for (auto &d: dist)
+            if (!fid.readDouble(d)) fail();
+      } else if (lineIs(first, last, "p")) {
+         lastenv = "p";
          for (int i = 0; i < m_numNodes; ++i) {
-            for (int v = 0; v < m_numVehicles; ++v) {
-               std::getline(fid, buf);
-               // Use only processing time of first vehicle.
-               // This is a issue with the instance format.
-               if (v != 0)
-                  continue;
-               std::stringstream stream(buf);
+            // Use only processing time of first vehicle.
+            // This is a issue with the instance format.
+            if (fid.nextLine(first, last)) {
+               TextScanner stream(first, last);
                for (int s = 0; s < m_numSkills; ++s) {
-                  stream >> m_nodeProcTime[i][s];
+                  if (!stream.readDouble(m_nodeProcTime[i * m_numSkills + s]))
+                     break;
                }
             }
+            // Rows of the remaining vehicles are not even tokenized.
+            for (int v = 1; v < m_numVehicles; ++v)
+               fid.skipLine();
          }
-      } else if (buf == "mind") {
-         lastenv = buf;
-         for (auto &i: m_nodeDelta)
-            fid >> std::get<0>(i);
-      } else if (buf == "maxd") {
-         lastenv = buf;
-         for (auto &i: m_nodeDelta)
-            fid >> std::get<1>(i);
-      } else if (buf == "e") {
-         lastenv = buf;
-         for (auto &i: m_nodeTw)
-            fid >> std::get<0>(i);
-      } else if (buf == "l") {
-         lastenv = buf;
-         for (auto &i: m_nodeTw)
-            fid >> std::get<1>(i);
+      } else if (lineIs(first, last, "mind")) {
+         lastenv = "mind";
+         for (auto &i: m_nodeDeltaMin)
+            if (!fid.readDouble(i)) fail();
+      } else if (lineIs(first, last, "maxd")) {
+         lastenv = "maxd";
+         for (auto &i: m_nodeDeltaMax)
+            if (!fid.readDouble(i)) fail();
+      } else if (lineIs(first, last, "e")) {
+         lastenv = "e";
+         for (auto &i: m_nodeTwMin)
+            if (!fid.readDouble(i)) fail();
+      } else if (lineIs(first, last, "l")) {
+         lastenv = "l";
+         for (auto &i: m_nodeTwMax)
+            if (!fid.readDouble(i)) fail();
       } else {
-         std::cout << "Unknow line content: " << buf << std::endl;
-         std::cout << "Line length: " << buf.length() << std::endl;
-         std::cout << "Last section read: " << lastenv << std::endl;
-         std::exit(EXIT_FAILURE);
+         throw std::runtime_error("Unknown line content in instance " + m_fname + ": " + std::string(first, last) +
+            " (last section read: " + lastenv + ").");
       }
    }
 
-   fid.close();
+   if (m_numNodes < 2 || m_numVehicles < 1 || m_numSkills < 1 ||
+      m_nodeReqSkills.size() != size_t(m_numNodes) * m_numSkills)
+      throw std::runtime_error("Instance " + m_fname + " misses or misorders the nbNodes, nbVehi and nbServi sections.");
 
    // Detect service type of double service nodes.
    for (int i: dscheck) {
-      int sksum = std::accumulate(m_nodeReqSkills[i].begin(), m_nodeReqSkills[i].end(), 0);
-      double dmin = std::get<0>(m_nodeDelta[i]);
+      int sksum = std::accumulate(&m_nodeReqSkills[i * m_numSkills], &m_nodeReqSkills[(i+1) * m_numSkills], 0);
+      double dmin = m_nodeDeltaMin[i];
 
       if (sksum == 2) {
          if (dmin <= 0.001) {
@@ -155,12 +407,13 @@ Instance::Instance(const char* fname) {
             m_nodeSvcType[i] = SvcType::PRED;
          }
       } else {
-         std::cout << "Double service node " << i << " requiring a invalid amount of "
-            << sksum << " service types." << std::endl;
-         std::abort();
+         throw std::runtime_error("Double service node " + std::to_string(i) + " requiring a invalid amount of " +
+            std::to_string(sksum) + " service types.");
       }
    }
 
+   // Instances without a distance section keep infinite distances.
+   dist.resize(m_numNodes * m_numNodes, std::numeric_limits<double>::infinity());
 }
 
 Instance::~Instance() {
@@ -180,11 +433,22 @@ int Instance::numSkills() const {
 }
 
 bool Instance::vehicleHasSkill(int vehicle, int skill) const {
-   return m_vehicleSkills[vehicle][skill];
+   return m_vehicleSkills[vehicle * m_numSkills + skill];
+}
+
+int Instance::vehicleClass(int vehicle) const {
+   return m_vehicleClass[vehicle];
+}
+
+int Instance::numVehicleClasses() const {
+   int count = 0;
+   for (int v = 0; v < m_numVehicles; ++v)
+      count += m_vehicleClass[v] == v;
+   return count;
 }
 
 bool Instance::nodeReqSkill(int node, int skill) const {
-   return m_nodeReqSkills[node][skill];
+   return m_nodeReqSkills[node * m_numSkills + skill];
 }
 
 Instance::SvcType Instance::nodeSvcType(int node) const {
@@ -192,67 +456,324 @@ Instance::SvcType Instance::nodeSvcType(int node) const {
 }
 
 double Instance::nodeDeltaMin(int node) const {
-   return std::get<0>(m_nodeDelta[node]);
+   return m_nodeDeltaMin[node];
 }
 
 double Instance::nodeDeltaMax(int node) const {
-   return std::get<1>(m_nodeDelta[node]);
+   return m_nodeDeltaMax[node];
 }
 
 double Instance::nodeTwMin(int node) const {
-   return std::get<0>(m_nodeTw[node]);
+   return m_nodeTwMin[node];
 }
 
 double Instance::nodeTwMax(int node) const {
-   return std::get<1>(m_nodeTw[node]);
+   return m_nodeTwMax[node];
 }
 
 double Instance::nodeProcTime(int node, int skill) const {
-   return m_nodeProcTime[node][skill];
+   return m_nodeProcTime[node * m_numSkills + skill];
 }
 
 double Instance::nodePosX(int node) const {
-   return std::get<0>(m_nodePos[node]);
+   return m_nodePosX[node];
 }
 
 double Instance::nodePosY(int node) const {
-   return std::get<1>(m_nodePos[node]);
+   return m_nodePosY[node];
 }
 
 double Instance::distance(int fromNode, int toNode) const {
-   return m_distances[fromNode][toNode];
+   switch (m_distMode) {
+      case DistanceMode::SYMMETRIC:
+         return m_distances[triIndex(fromNode, toNode)];
+      case DistanceMode::FLOAT32:
+         if (m_distTri)
+            return m_distancesFlt[triIndex(fromNode, toNode)];
+         return m_distancesFlt[fromNode * m_numNodes + toNode];
+      case DistanceMode::EUCLIDEAN: {
+         const double dx = m_nodePosX[toNode] - m_nodePosX[fromNode];
+         const double dy = m_nodePosY[toNode] - m_nodePosY[fromNode];
+         return std::sqrt(dx*dx + dy*dy);
+      }
+      default:
+         return m_distances[fromNode * m_numNodes + toNode];
+   }
+}
+
+void Instance::distanceRow(int fromNode, double *out) const {
+   if (m_distMode == DistanceMode::FULL) {
+      std::copy_n(m_distances.begin() + fromNode * m_numNodes, m_numNodes, out);
+   } else if (m_distMode == DistanceMode::EUCLIDEAN) {
+      const double *px = m_nodePosX.data();
+      const double *py = m_nodePosY.data();
+      int j = 0;
+#ifdef __SSE2__
+      // Two distances per iteration.
+      const __m128d x0 = _mm_set1_pd(px[fromNode]);
+      const __m128d y0 = _mm_set1_pd(py[fromNode]);
+      for (; j + 1 < m_numNodes; j += 2) {
+         __m128d dx = _mm_sub_pd(_mm_loadu_pd(px + j), x0);
+         __m128d dy = _mm_sub_pd(_mm_loadu_pd(py + j), y0);
+         __m128d sq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+         _mm_storeu_pd(out + j, _mm_sqrt_pd(sq));
+      }
+#endif
+      for (; j < m_numNodes; ++j) {
+         const double dx = px[j] - px[fromNode];
+         const double dy = py[j] - py[fromNode];
+         out[j] = std::sqrt(dx*dx + dy*dy);
+      }
+   } else {
+      for (int j = 0; j < m_numNodes; ++j)
+         out[j] = distance(fromNode, j);
+   }
+}
+
+Instance::DistanceMode Instance::distanceMode() const {
+   return m_distMode;
 }
 
 const std::string & Instance::fileName() const {
    return m_fname;
 }
 
-void Instance::resize() {
-   m_vehicleSkills.resize(m_numVehicles);
-   for (auto &row: m_vehicleSkills)
-      row.resize(m_numSkills, 0);
+uint64_t Instance::contentHash() const {
+   return m_hash;
+}
+
+void Instance::setNodeTw(int node, double twMin, double twMax) {
+   m_nodeTwMin[node] = twMin;
+   m_nodeTwMax[node] = twMax;
+   rehash();
+}
+
+void Instance::cancelPatient(int node) {
+   for (int s = 0; s < m_numSkills; ++s)
+      m_nodeReqSkills[node * m_numSkills + s] = 0;
+   m_nodeSvcType[node] = NONE;
+   rehash();
+}
+
+int Instance::addPatient(const Patient &patient) {
+   const int n = m_numNodes;
+   const int k = n - 1;
+
+   std::vector <double> oldDist;
+   denseDistances(oldDist);
+
+   m_nodeReqSkills.insert(m_nodeReqSkills.begin() + k * m_numSkills,
+      patient.reqSkills.begin(), patient.reqSkills.end());
+   m_nodeProcTime.insert(m_nodeProcTime.begin() + k * m_numSkills,
+      patient.procTime.begin(), patient.procTime.end());
+   m_nodeSvcType.insert(m_nodeSvcType.begin() + k, patient.svcType);
+   m_nodeDeltaMin.insert(m_nodeDeltaMin.begin() + k, patient.deltaMin);
+   m_nodeDeltaMax.insert(m_nodeDeltaMax.begin() + k, patient.deltaMax);
+   m_nodeTwMin.insert(m_nodeTwMin.begin() + k, patient.twMin);
+   m_nodeTwMax.insert(m_nodeTwMax.begin() + k, patient.twMax);
+   m_nodePosX.insert(m_nodePosX.begin() + k, patient.posX);
+   m_nodePosY.insert(m_nodePosY.begin() + k, patient.posY);
+   m_numNodes = n + 1;
+
+   // Old nodes keep their indices, but the end depot (n-1 -> n).
+   auto oldIndex = [k] (int i) {
+      return i < k ? i : i - 1;
+   };
+   std::vector <double> dist(size_t(n+1) * size_t(n+1));
+   for (int i = 0; i <= n; ++i) {
+      for (int j = 0; j <= n; ++j) {
+         if (i == k || j == k) {
+            const double dx = m_nodePosX[i] - m_nodePosX[j];
+            const double dy = m_nodePosY[i] - m_nodePosY[j];
+            dist[i * (n+1) + j] = std::sqrt(dx*dx + dy*dy);
+         } else {
+            dist[i * (n+1) + j] = oldDist[oldIndex(i) * n + oldIndex(j)];
+         }
+      }
+   }
+
+   setupDistances(dist, m_distMode);
+   rehash();
+   return k;
+}
+
+size_t Instance::memoryBytes() const {
+   return sizeof(*this) + m_fname.capacity() +
+      (m_vehicleSkills.capacity() + m_vehicleClass.capacity() + m_nodeReqSkills.capacity()) * sizeof(int) +
+      m_nodeSvcType.capacity() * sizeof(SvcType) +
+      (m_nodeDeltaMin.capacity() + m_nodeDeltaMax.capacity() + m_nodeTwMin.capacity() +
+         m_nodeTwMax.capacity() + m_nodeProcTime.capacity() + m_nodePosX.capacity() +
+         m_nodePosY.capacity() + m_distances.capacity()) * sizeof(double) +
+      m_distancesFlt.capacity() * sizeof(float);
+}
+
+void Instance::setupVehicleClasses() {
+   m_vehicleClass.resize(m_numVehicles);
+   for (int v = 0; v < m_numVehicles; ++v) {
+      m_vehicleClass[v] = v;
+      for (int w = 0; w < v; ++w) {
+         if (std::equal(&m_vehicleSkills[v * m_numSkills], &m_vehicleSkills[(v+1) * m_numSkills],
+               &m_vehicleSkills[w * m_numSkills])) {
+            m_vehicleClass[v] = w;
+            break;
+         }
+      }
+   }
+}
+
+std::string Instance::cachePath(const char *fname) {
+   return std::string(fname) + ".cache";
+}
 
-   m_nodeReqSkills.resize(m_numNodes);
-   for (auto &row: m_nodeReqSkills)
-      row.resize(m_numSkills, 0);
+void Instance::serialize(const std::vector <double> &dist, std::vector <char> &payload) const {
+   auto append = [&payload] (const void *data, size_t bytes) {
+      const char *p = static_cast<const char *>(data);
+      payload.insert(payload.end(), p, p + bytes);
+   };
+
+   std::vector <int32_t> svc(m_nodeSvcType.begin(), m_nodeSvcType.end());
+
+   payload.clear();
+   payload.reserve(cachePayloadSize(m_numNodes, m_numVehicles, m_numSkills));
+   append(m_vehicleSkills.data(), m_vehicleSkills.size() * sizeof(int32_t));
+   append(m_nodeReqSkills.data(), m_nodeReqSkills.size() * sizeof(int32_t));
+   append(svc.data(), svc.size() * sizeof(int32_t));
+   append(m_nodeDeltaMin.data(), m_nodeDeltaMin.size() * sizeof(double));
+   append(m_nodeDeltaMax.data(), m_nodeDeltaMax.size() * sizeof(double));
+   append(m_nodeTwMin.data(), m_nodeTwMin.size() * sizeof(double));
+   append(m_nodeTwMax.data(), m_nodeTwMax.size() * sizeof(double));
+   append(m_nodeProcTime.data(), m_nodeProcTime.size() * sizeof(double));
+   append(m_nodePosX.data(), m_nodePosX.size() * sizeof(double));
+   append(m_nodePosY.data(), m_nodePosY.size() * sizeof(double));
+   append(dist.data(), dist.size() * sizeof(double));
+}
+
+size_t Instance::cachePayloadSize(int numNodes, int numVehicles, int numSkills) {
+   const size_t n = size_t(numNodes), v = size_t(numVehicles), s = size_t(numSkills);
+   return (v*s + n*s + n) * sizeof(int32_t) + (6*n + n*s + n*n) * sizeof(double);
+}
+
+bool Instance::readCache(const std::string &path, std::vector <double> &dist) {
+   struct stat src;
+   if (stat(m_fname.c_str(), &src) != 0)
+      return false;
+
+   MappedFile file(path.c_str());
+   if (!file.isOpen() || file.size() < sizeof(CacheHeader))
+      return false;
+
+   CacheHeader hdr;
+   std::memcpy(&hdr, file.data(), sizeof hdr);
+   if (std::memcmp(hdr.magic, cacheMagic, sizeof hdr.magic) != 0 || hdr.version != cacheVersion)
+      return false;
+   if (hdr.numNodes <= 0 || hdr.numVehicles <= 0 || hdr.numSkills <= 0)
+      return false;
+
+   // Stale caches (text file changed after the cache was written) are ignored.
+   if (hdr.srcSize != uint64_t(src.st_size) || hdr.srcMtime != int64_t(src.st_mtime))
+      return false;
+
+   const size_t bytes = cachePayloadSize(hdr.numNodes, hdr.numVehicles, hdr.numSkills);
+   if (hdr.payloadSize != bytes || file.size() != sizeof hdr + bytes)
+      return false;
+
+   const char *data = file.data() + sizeof hdr;
+   if (hashBytes(data, bytes) != hdr.checksum)
+      return false;
+
+   resize(hdr.numNodes, hdr.numVehicles, hdr.numSkills);
+
+   auto extract = [&data] (void *dest, size_t bytes) {
+      std::memcpy(dest, data, bytes);
+      data += bytes;
+   };
+
+   std::vector <int32_t> svc(m_numNodes);
+   dist.resize(m_numNodes * m_numNodes);
+
+   extract(m_vehicleSkills.data(), m_vehicleSkills.size() * sizeof(int32_t));
+   extract(m_nodeReqSkills.data(), m_nodeReqSkills.size() * sizeof(int32_t));
+   extract(svc.data(), svc.size() * sizeof(int32_t));
+   extract(m_nodeDeltaMin.data(), m_nodeDeltaMin.size() * sizeof(double));
+   extract(m_nodeDeltaMax.data(), m_nodeDeltaMax.size() * sizeof(double));
+   extract(m_nodeTwMin.data(), m_nodeTwMin.size() * sizeof(double));
+   extract(m_nodeTwMax.data(), m_nodeTwMax.size() * sizeof(double));
+   extract(m_nodeProcTime.data(), m_nodeProcTime.size() * sizeof(double));
+   extract(m_nodePosX.data(), m_nodePosX.size() * sizeof(double));
+   extract(m_nodePosY.data(), m_nodePosY.size() * sizeof(double));
+   extract(dist.data(), dist.size() * sizeof(double));
+
+   for (int i = 0; i < m_numNodes; ++i)
+      m_nodeSvcType[i] = (SvcType) svc[i];
+
+   m_hash = hdr.checksum;
+   return true;
+}
+
+void Instance::writeCache(const std::string &path, const std::vector <char> &payload) const {
+   struct stat src;
+   if (stat(m_fname.c_str(), &src) != 0)
+      return;
+
+   CacheHeader hdr;
+   std::memset(&hdr, 0, sizeof hdr);
+   std::memcpy(hdr.magic, cacheMagic, sizeof hdr.magic);
+   hdr.version = cacheVersion;
+   hdr.numNodes = m_numNodes;
+   hdr.numVehicles = m_numVehicles;
+   hdr.numSkills = m_numSkills;
+   hdr.srcSize = uint64_t(src.st_size);
+   hdr.srcMtime = int64_t(src.st_mtime);
+   hdr.payloadSize = payload.size();
+   hdr.checksum = m_hash;
+
+   // Write to a temporary file and rename it, so that concurrent runs never
+   // see a partially written cache. Failures (e.g., read-only directories)
+   // only mean the text file will be parsed again next time.
+   const std::string tmp = path + ".tmp" + std::to_string(getpid());
+   FILE *fid = std::fopen(tmp.c_str(), "wb");
+   if (!fid)
+      return;
+   bool ok = std::fwrite(&hdr, sizeof hdr, 1, fid) == 1 &&
+      std::fwrite(payload.data(), 1, payload.size(), fid) == payload.size();
+   ok = std::fclose(fid) == 0 && ok;
+   if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+      std::remove(tmp.c_str());
+}
+
+uint64_t Instance::hashBytes(const void *data, size_t bytes) {
+   // FNV-1a applied to 64-bit words, followed by the remaining bytes.
+   const uint64_t prime = 1099511628211ull;
+   uint64_t h = 14695981039346656037ull;
+   const char *p = static_cast<const char *>(data);
+   for (; bytes >= 8; bytes -= 8, p += 8) {
+      uint64_t w;
+      std::memcpy(&w, p, 8);
+      h = (h ^ w) * prime;
+   }
+   for (; bytes > 0; --bytes, ++p)
+      h = (h ^ uint64_t(uint8_t(*p))) * prime;
+   return h;
+}
+
+void Instance::resize() {
+   m_vehicleSkills.resize(m_numVehicles * m_numSkills, 0);
+   m_nodeReqSkills.resize(m_numNodes * m_numSkills, 0);
 
    m_nodeSvcType.resize(m_numNodes, SvcType::NONE);
 
 
    const double dblInf = std::numeric_limits<double>::infinity();
-   m_nodeDelta.resize(m_numNodes, std::make_tuple(-dblInf, dblInf));
+   m_nodeDeltaMin.resize(m_numNodes, -dblInf);
+   m_nodeDeltaMax.resize(m_numNodes, dblInf);
 
-   m_nodeTw.resize(m_numNodes, std::make_tuple(-dblInf, dblInf));
+   m_nodeTwMin.resize(m_numNodes, -dblInf);
+   m_nodeTwMax.resize(m_numNodes, dblInf);
 
-   m_nodeProcTime.resize(m_numNodes);
-   for (auto &row: m_nodeProcTime)
-      row.resize(m_numSkills, dblInf);
+   m_nodeProcTime.resize(m_numNodes * m_numSkills, dblInf);
 
-   m_nodePos.resize(m_numNodes, std::make_tuple(-dblInf, dblInf));
-
-   m_distances.resize(m_numNodes);
-   for (auto &row: m_distances)
-      row.resize(m_numNodes, dblInf);
+   m_nodePosX.resize(m_numNodes, -dblInf);
+   m_nodePosY.resize(m_numNodes, dblInf);
 }
 
 void Instance::resize(int numNodes, int numVehicles, int numSkills) {
@@ -263,6 +784,90 @@ void Instance::resize(int numNodes, int numVehicles, int numSkills) {
    resize();
 }
 
+void Instance::setupDistances(const std::vector <double> &dist, DistanceMode mode) {
+   const int n = m_numNodes;
+
+   bool symmetric = true;
+   for (int i = 0; i < n && symmetric; ++i)
+      for (int j = i+1; j < n; ++j)
+         if (dist[i*n + j] != dist[j*n + i]) {
+            symmetric = false;
+            break;
+         }
+
+   if (mode == DistanceMode::EUCLIDEAN) {
+      // Coordinates in the files are integral and the matrix is printed with
+      // single precision, so a small absolute tolerance is enough.
+      m_distMode = mode;
+      std::vector <double> row(n);
+      for (int i = 0; i < n && m_distMode == mode; ++i) {
+         distanceRow(i, row.data());
+         for (int j = 0; j < n; ++j) {
+            if (std::fabs(row[j] - dist[i*n + j]) > 1e-3) {
+               std::cout << "Instance " << m_fname << ": d(" << i << "," << j << ") = " <<
+                  dist[i*n + j] << " does not match the coordinates; " <<
+                  "euclidean distances disabled." << std::endl;
+               mode = symmetric ? DistanceMode::SYMMETRIC : DistanceMode::FULL;
+               break;
+            }
+         }
+      }
+   }
+
+   if (mode == DistanceMode::SYMMETRIC && !symmetric) {
+      std::cout << "Instance " << m_fname << ": distance matrix is not symmetric; " <<
+         "using full storage." << std::endl;
+      mode = DistanceMode::FULL;
+   }
+
+   m_distMode = mode;
+   m_distTri = symmetric && mode != DistanceMode::FULL;
+   m_distances.clear();
+   m_distancesFlt.clear();
+
+   if (mode == DistanceMode::FULL) {
+      m_distances = dist;
+   } else if (mode == DistanceMode::SYMMETRIC) {
+      m_distances.resize(n * (n+1) / 2);
+      for (int i = 0; i < n; ++i)
+         for (int j = i; j < n; ++j)
+            m_distances[triIndex(i, j)] = dist[i*n + j];
+   } else if (mode == DistanceMode::FLOAT32) {
+      if (m_distTri) {
+         m_distancesFlt.resize(n * (n+1) / 2);
+         for (int i = 0; i < n; ++i)
+            for (int j = i; j < n; ++j)
+               m_distancesFlt[triIndex(i, j)] = static_cast<float>(dist[i*n + j]);
+      } else {
+         m_distancesFlt.resize(dist.size());
+         std::transform(dist.begin(), dist.end(), m_distancesFlt.begin(), [] (double d) {
+            return static_cast<float>(d);
+         });
+      }
+   }
+}
+
+void Instance::denseDistances(std::vector <double> &dist) const {
+   dist.resize(size_t(m_numNodes) * size_t(m_numNodes));
+   for (int i = 0; i < m_numNodes; ++i)
+      distanceRow(i, dist.data() + size_t(i) * m_numNodes);
+}
+
+void Instance::rehash() {
+   std::vector <double> dist;
+   denseDistances(dist);
+
+   std::vector <char> payload;
+   serialize(dist, payload);
+   m_hash = hashBytes(payload.data(), payload.size());
+}
+
+int Instance::triIndex(int i, int j) const {
+   if (i > j)
+      std::swap(i, j);
+   return i * m_numNodes - i * (i-1) / 2 + (j - i);
+}
+
 std::ostream &operator<<(std::ostream &out, const Instance &inst) {
    out << "nbNodes\n" << inst.numNodes() << "\n";
    out << "nbVehi\n" << inst.numVehicles() << "\n";
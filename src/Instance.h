@@ -27,7 +27,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <iosfwd>
+#include <string>
 #include <vector>
 #include <tuple>
 
@@ -41,7 +43,51 @@ public:
       MAX_
    };
 
-   Instance(const char *fname);
+   /**
+    * Storage used to answer `distance` queries.
+    * FULL: Dense N x N matrix of doubles, as read from the file.
+    * SYMMETRIC: Upper triangular matrix of doubles (requires d(i,j) = d(j,i)).
+    * FLOAT32: Same layout as SYMMETRIC (or FULL, if asymmetric), but using floats.
+    * EUCLIDEAN: No matrix at all; distances are computed from node coordinates
+    *   (requires the matrix to match the coordinates).
+    * Requirements are validated at load time; the instance falls back to the
+    * closest mode available when they are not met.
+    */
+   enum class DistanceMode: int {
+      FULL      = 0,
+      SYMMETRIC = 1,
+      FLOAT32   = 2,
+      EUCLIDEAN = 3,
+      MAX_
+   };
+
+   /**
+    * Data of a patient added after loading (see `addPatient`). `reqSkills`
+    * and `procTime` have one entry per skill.
+    */
+   struct Patient {
+      double posX = 0.0;
+      double posY = 0.0;
+      double twMin = 0.0;
+      double twMax = 0.0;
+      SvcType svcType = SINGLE;
+      double deltaMin = 0.0;
+      double deltaMax = 0.0;
+      std::vector <int> reqSkills;
+      std::vector <double> procTime;
+   };
+
+   static const char *distanceModeName(DistanceMode mode);
+   static bool parseDistanceMode(const char *name, DistanceMode &mode);
+
+   /**
+    * Loads the instance from text file `fname`. When `useCache` is set, a
+    * valid binary cache (`cachePath(fname)`) is preferred over the text file;
+    * if there is none, it is written after parsing the text.
+    * Throws `std::runtime_error` if the file can not be read or is
+    * malformed.
+    */
+   Instance(const char *fname, DistanceMode distMode = DistanceMode::FULL, bool useCache = true);
    virtual ~Instance();
 
    int numVehicles() const;
@@ -51,6 +97,14 @@ public:
    bool vehicleHasSkill(int vehicle, int skill) const;
    bool nodeReqSkill(int node, int skill) const;
 
+   /**
+    * Vehicles with the same skills are interchangeable. Each one belongs to
+    * the class of the first vehicle with its skills, identified by the index
+    * of that vehicle.
+    */
+   int vehicleClass(int vehicle) const;
+   int numVehicleClasses() const;
+
    SvcType nodeSvcType(int node) const;
 
    double nodeDeltaMin(int node) const;
@@ -66,8 +120,41 @@ public:
 
    double distance(int fromNode, int toNode) const;
 
+   /**
+    * Writes the distances from `fromNode` to every node into `out`, which
+    * must have room for `numNodes()` values.
+    */
+   void distanceRow(int fromNode, double *out) const;
+
+   DistanceMode distanceMode() const;
+
    const std::string &fileName() const;
 
+   /**
+    * Hash of the instance data, independent of the file it was read from.
+    */
+   uint64_t contentHash() const;
+
+   static std::string cachePath(const char *fname);
+
+   /**
+    * Changes to the loaded instance, for re-optimization of a plan. The
+    * content hash is updated accordingly; the files are not modified.
+    * setNodeTw: new time window of `node`.
+    * cancelPatient: `node` no longer requires any service.
+    * addPatient: inserts a patient at index `numNodes()-2` (the end depot
+    *   moves one index up) and returns its index. Distances to the new node
+    *   are euclidean, computed from the coordinates.
+    */
+   void setNodeTw(int node, double twMin, double twMax);
+   void cancelPatient(int node);
+   int addPatient(const Patient &patient);
+
+   /**
+    * Bytes allocated by the instance data (arrays and distance storage).
+    */
+   size_t memoryBytes() const;
+
    friend std::ostream &operator<<(std::ostream &out, const Instance &inst);
 
 protected:
@@ -77,20 +164,50 @@ protected:
    void resize();
    void resize(int numNodes, int numVehicles, int numSkills);
 
+   void readText(std::vector <double> &dist);
+
+   /**
+    * Binary cache support. The payload holds every array of the instance,
+    * plus the dense distance matrix `dist`.
+    */
+   void serialize(const std::vector <double> &dist, std::vector <char> &payload) const;
+   bool readCache(const std::string &path, std::vector <double> &dist);
+   void writeCache(const std::string &path, const std::vector <char> &payload) const;
+   static size_t cachePayloadSize(int numNodes, int numVehicles, int numSkills);
+   static uint64_t hashBytes(const void *data, size_t bytes);
+
+   /**
+    * Builds the distance storage of mode `mode` from the dense matrix `dist`.
+    */
+   void setupDistances(const std::vector <double> &dist, DistanceMode mode);
+   void denseDistances(std::vector <double> &dist) const;
+   void rehash();
+   void setupVehicleClasses();
+   int triIndex(int i, int j) const;
+
 private:
    std::string m_fname;
+   uint64_t m_hash;
    int m_numNodes;
    int m_numVehicles;
    int m_numSkills;
 
-   std::vector <std::vector<int>> m_vehicleSkills;
-   std::vector <std::vector<int>> m_nodeReqSkills;
+   // Flat matrices: vehicle x skill, node x skill.
+   std::vector <int> m_vehicleSkills;
+   std::vector <int> m_vehicleClass;
+   std::vector <int> m_nodeReqSkills;
    std::vector <SvcType> m_nodeSvcType;
 
-   std::vector <std::tuple<double, double>> m_nodeDelta;
-   std::vector <std::tuple<double, double>> m_nodeTw;
-   std::vector <std::vector<double>> m_nodeProcTime;
-   std::vector <std::tuple<double, double>> m_nodePos;
-
-   std::vector <std::vector <double>> m_distances;
+   std::vector <double> m_nodeDeltaMin;
+   std::vector <double> m_nodeDeltaMax;
+   std::vector <double> m_nodeTwMin;
+   std::vector <double> m_nodeTwMax;
+   std::vector <double> m_nodeProcTime;
+   std::vector <double> m_nodePosX;
+   std::vector <double> m_nodePosY;
+
+   DistanceMode m_distMode;
+   bool m_distTri;
+   std::vector <double> m_distances;
+   std::vector <float> m_distancesFlt;
 };
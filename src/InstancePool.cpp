@@ -0,0 +1,60 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "InstancePool.h"
+
+
+using namespace std;
+
+
+InstancePool::InstancePool(Instance::DistanceMode distMode, bool useCache):
+   m_distMode(distMode), m_useCache(useCache) {
+   // Empty
+}
+
+InstancePool::~InstancePool() {
+   // Empty
+}
+
+const Instance &InstancePool::get(const std::string &fname) {
+   Entry *entry = nullptr;
+   {
+      lock_guard <mutex> guard(m_mutex);
+      unique_ptr <Entry> &slot = m_entries[fname];
+      if (!slot)
+         slot.reset(new Entry);
+      entry = slot.get();
+   }
+
+   // Other instances may be loaded concurrently; only users of this one wait.
+   call_once(entry->m_loaded, [&] () {
+      entry->m_inst.reset(new Instance(fname.c_str(), m_distMode, m_useCache));
+   });
+
+   return *entry->m_inst;
+}
@@ -0,0 +1,110 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "LowerBounder.h"
+
+#include <limits>
+#include <memory>
+
+
+using namespace std;
+
+
+LowerBounder::LowerBounder(const Instance &inst, const string &cacheDir, MipModel::Formulation formulation,
+   int chunkSeconds): m_inst(inst), m_cacheDir(cacheDir), m_formulation(formulation),
+   m_chunkSeconds(chunkSeconds), m_stop(false), m_proven(false),
+   m_bound(-numeric_limits<double>::infinity()), m_incumbent(numeric_limits<double>::infinity()) {
+   // Empty
+}
+
+LowerBounder::~LowerBounder() {
+   stop();
+}
+
+void LowerBounder::start() {
+   if (m_thread.joinable())
+      return;
+   m_stop = false;
+   m_thread = thread(&LowerBounder::run, this);
+}
+
+void LowerBounder::stop() {
+   m_stop = true;
+   if (m_thread.joinable())
+      m_thread.join();
+}
+
+void LowerBounder::offerIncumbent(double obj) {
+   double current = m_incumbent.load();
+   while (obj < current && !m_incumbent.compare_exchange_weak(current, obj))
+      ;
+}
+
+double LowerBounder::bound() const {
+   return m_bound.load();
+}
+
+bool LowerBounder::proven() const {
+   return m_proven.load();
+}
+
+void LowerBounder::run() {
+   // A run shorter than the build stops it between families of constraints,
+   // without a bound.
+   unique_ptr <MipModel> built;
+   try {
+      built.reset(new MipModel(m_inst, m_cacheDir, m_formulation, &m_stop));
+   } catch (const MipModel::BuildCancelled &) {
+      return;
+   }
+   MipModel &model = *built;
+   model.setQuiet(true);
+   model.maxThreads(1);
+   model.timeLimit(m_chunkSeconds);
+
+   // Solving again an unchanged model resumes its branch and bound, so each
+   // chunk continues the search of the previous one.
+   double cutoff = numeric_limits<double>::infinity();
+   while (!m_stop) {
+      const double incumbent = m_incumbent.load();
+      if (incumbent < cutoff) {
+         cutoff = incumbent;
+         model.cutoff(cutoff);
+      }
+      model.trySolve();
+
+      bool complete = false;
+      const double lb = model.provenBound(complete);
+      if (lb > m_bound.load())
+         m_bound = lb;
+      if (complete) {
+         m_proven = true;
+         break;
+      }
+   }
+}
@@ -0,0 +1,86 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "Instance.h"
+#include "MipModel.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * Global lower bound of an instance, computed in a background thread while
+ * the search runs. The thread builds its own MIP model (hence its own CPLEX
+ * environment, as in concurrent runs) and solves the full model by branch
+ * and bound, in chunks of `chunkSeconds`, publishing the best bound after
+ * each chunk. The incumbent of the search is used as the cutoff, so nodes
+ * that can not improve it are pruned, and the bound reaches the incumbent
+ * once it is proven optimal.
+ */
+class LowerBounder {
+public:
+   LowerBounder(const Instance &inst, const std::string &cacheDir = "",
+      MipModel::Formulation formulation = MipModel::Formulation::VEHICLE, int chunkSeconds = 2);
+
+   /** Stops the thread (see `stop`). */
+   virtual ~LowerBounder();
+
+   void start();
+
+   /**
+    * Stops the thread and waits for it; it stops at the end of the current
+    * chunk, or between the families of constraints while the model is
+    * built, leaving no bound. The bound remains available.
+    */
+   void stop();
+
+   /** Objective of the incumbent of the search, used as cutoff from the next chunk on. */
+   void offerIncumbent(double obj);
+
+   /** Best bound found so far; -infinity if none. */
+   double bound() const;
+
+   /** Whether the branch and bound finished, so `bound` is the optimum (or the incumbent is optimal). */
+   bool proven() const;
+
+private:
+   const Instance &m_inst;
+   std::string m_cacheDir;
+   MipModel::Formulation m_formulation;
+   int m_chunkSeconds;
+
+   std::thread m_thread;
+   std::atomic <bool> m_stop;
+   std::atomic <bool> m_proven;
+   std::atomic <double> m_bound;
+   std::atomic <double> m_incumbent;
+
+   void run();
+};
@@ -0,0 +1,83 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+MappedFile::MappedFile(const char *fname): m_fd(-1), m_data(nullptr), m_size(0) {
+   m_fd = open(fname, O_RDONLY);
+   if (m_fd < 0)
+      return;
+
+   struct stat st;
+   if (fstat(m_fd, &st) != 0) {
+      close(m_fd);
+      m_fd = -1;
+      return;
+   }
+
+   m_size = size_t(st.st_size);
+   if (m_size == 0)
+      return;
+
+   m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+   if (m_data == MAP_FAILED) {
+      m_data = nullptr;
+      m_size = 0;
+      close(m_fd);
+      m_fd = -1;
+      return;
+   }
+
+   // The file is read from start to end just once.
+   madvise(m_data, m_size, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+   if (m_data)
+      munmap(m_data, m_size);
+   if (m_fd >= 0)
+      close(m_fd);
+}
+
+bool MappedFile::isOpen() const {
+   return m_fd >= 0;
+}
+
+const char *MappedFile::data() const {
+   return static_cast<const char *>(m_data);
+}
+
+size_t MappedFile::size() const {
+   return m_size;
+}
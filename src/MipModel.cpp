@@ -27,60 +27,352 @@
 
 #include "MipModel.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
 
+#include <unistd.h>
 
-using namespace std;
 
-MipModel::MipModel(const Instance &inst): m_inst(inst) {
-   // Basic CPLEX variables.
-   m_model = IloModel(m_env);
-   m_cplex = IloCplex(m_model);
-   m_model.setName("routing_cost");
-
-   // Helper objects.
-   IloExpr expr(m_env);
-   char buf[128] = "";
+using namespace std;
 
-   // Maximum tardiness variable.
-   m_Tmax = IloNumVar(m_env, 0., IloInfinity, IloNumVar::Float, "tmax");
+const char *MipModel::formulationName(Formulation formulation) {
+   switch (formulation) {
+      case Formulation::VEHICLE: return "vehicle";
+      case Formulation::AGGREGATED: return "aggregated";
+      default: return "unknown";
+   }
+}
 
-   double bigM = 1e6;
+bool MipModel::parseFormulation(const char *name, Formulation &formulation) {
+   for (int f = 0; f < (int) Formulation::MAX_; ++f) {
+      if (string(name) == formulationName((Formulation) f)) {
+         formulation = (Formulation) f;
+         return true;
+      }
+   }
+   return false;
+}
 
+MipModel::MipModel(const Instance &inst, const std::string &cacheDir, Formulation formulation,
+   const std::atomic <bool> *cancel): m_inst(inst), m_fromCache(false), m_formulation(formulation), m_cancel(cancel) {
    m_xSeq = IloNumVarArray(m_env);
    m_solXSeq = IloNumArray(m_env);
+   for (int v = 0; v < m_inst.numVehicles(); ++v)
+      m_vehicleX.push_back(IloNumVarArray(m_env));
+   m_removedX = IloNumVarArray(m_env);
+   m_removedLpX = IloNumArray(m_env);
+   m_removedLpRc = IloNumArray(m_env);
+   m_timeFixed.assign(m_inst.numVehicles(), 0);
+   m_symPair[0] = m_symPair[1] = -1;
+   m_lpX = IloNumArray(m_env);
+   m_lpRc = IloNumArray(m_env);
+   m_lpObj = 0.0;
+   m_lpValid = false;
+   m_propagatedObj = m_tardinessBound = numeric_limits<double>::infinity();
+
+   allocateVars();
+
+   if (cacheDir.empty()) {
+      build();
+      return;
+   }
 
-   // Create decision variables x.
+   // The content hash does not depend on the distance mode, but the
+   // objective coefficients do, so other modes and formulations are kept
+   // apart. The name of the original formulation with full distances is
+   // kept as it was, so existing caches remain valid.
+   std::string suffix;
+   if (m_inst.distanceMode() != Instance::DistanceMode::FULL)
+      suffix += std::string("-") + Instance::distanceModeName(m_inst.distanceMode());
+   if (m_formulation != Formulation::VEHICLE)
+      suffix += std::string("-") + formulationName(m_formulation);
+   char name[64];
+   snprintf(name, sizeof name, "/model-%016llx-v%d", (unsigned long long) m_inst.contentHash(), modelCacheVersion);
+   const std::string path = cacheDir + name + suffix + ".sav";
+
+   if (ifstream(path).good() && load(path)) {
+      m_fromCache = true;
+      return;
+   }
+
+   build();
+
+   // Export to a temporary file first, so that concurrent runs never import
+   // a partially written model.
+   const std::string tmp = path + ".tmp" + to_string(getpid()) + "-" +
+      to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+   try {
+      m_cplex.exportModel(tmp.c_str());
+      if (rename(tmp.c_str(), path.c_str()) != 0)
+         remove(tmp.c_str());
+   } catch (IloException &e) {
+      cout << "MipModel: could not write model cache " << path << ": " << e.getMessage() << endl;
+      remove(tmp.c_str());
+   }
+}
+
+void MipModel::allocateVars() {
    m_x = Var4D(m_env, m_inst.numNodes() - 1);
    for (int i = 0; i < m_inst.numNodes() - 1; ++i) {
       m_x[i] = Var3D(m_env, m_inst.numNodes() - 1);
-
       for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
          m_x[i][j] = Var2D(m_env, m_inst.numVehicles());
-
-         for (int v = 0; v < m_inst.numVehicles(); ++v) {
+         for (int v = 0; v < m_inst.numVehicles(); ++v)
             m_x[i][j][v] = Var1D(m_env, m_inst.numSkills());
+      }
+   }
 
-            for (int s = 0; s < m_inst.numSkills(); ++s) {
+   m_z = Var2D(m_env, m_inst.numNodes() - 2);
+   for (int i = 1; i < m_inst.numNodes() - 1; ++i)
+      m_z[i-1] = Var1D(m_env, m_inst.numSkills());
+
+   m_t = Var3D(m_env, m_inst.numNodes() - 1);
+   for (int i = 0; i < m_inst.numNodes() - 1; ++i) {
+      m_t[i] = Var2D(m_env, m_inst.numVehicles());
+      for (int v = 0; v < m_inst.numVehicles(); ++v)
+         m_t[i][v] = Var1D(m_env, m_inst.numSkills());
+   }
 
-               // Does not create unnecessary variables.
-               // Remove all variables which represent unfeasible assignment of
-               // tasks, but keep all arcs departing from /arriving to the depot.
-               if (i == j && j != 0)
+   // Handles of the constraints changed by incremental updates.
+   const int n = m_inst.numNodes() - 1, nv = m_inst.numVehicles(), ns = m_inst.numSkills();
+   m_depotSrc.assign(nv, IloRange());
+   m_depotSink.assign(nv, IloRange());
+   m_flowCons.assign(n * nv, IloRange());
+   m_assignCons.assign(n * ns, IloRange());
+   m_twEndCons.assign(n * nv * ns, IloRange());
+   m_syncCons.clear();
+   m_svcStart.assign(n * ns, IloNumVar());
+   m_svcLinks.assign(2 * n * nv * ns, IloRange());
+}
+
+bool MipModel::load(const std::string &path) {
+   m_model = IloModel(m_env);
+   m_cplex = IloCplex(m_env);
+
+   IloNumVarArray vars(m_env);
+   IloRangeArray rngs(m_env);
+   try {
+      m_cplex.importModel(m_model, path.c_str(), m_obj, vars, rngs);
+   } catch (IloException &e) {
+      cout << "MipModel: could not import model cache " << path << ": " << e.getMessage() << endl;
+      m_model.end();
+      m_cplex.end();
+      return false;
+   }
+
+   // Rebind the variable handles using the names given by `build`.
+   int nx = 0, nt = 0, nz = 0, ntmax = 0;
+   const int n = m_inst.numNodes(), nv = m_inst.numVehicles(), ns = m_inst.numSkills();
+   for (IloInt k = 0; k < vars.getSize(); ++k) {
+      const char *name = vars[k].getName();
+      int i, j, v, s;
+      if (!name) {
+         continue;
+      } else if (sscanf(name, "x(%d,%d,%d,%d)", &i, &j, &v, &s) == 4) {
+         if (i >= 0 && i < n-1 && j >= 0 && j < n-1 && v >= 0 && v < nv && s >= 0 && s < ns) {
+            m_x[i][j][v][s] = vars[k];
+            ++nx;
+         }
+      } else if (sscanf(name, "t(%d,%d,%d)", &i, &v, &s) == 3) {
+         if (i >= 0 && i < n-1 && v >= 0 && v < nv && s >= 0 && s < ns) {
+            m_t[i][v][s] = vars[k];
+            ++nt;
+         }
+      } else if (sscanf(name, "z(%d,%d)", &i, &s) == 2) {
+         if (i >= 1 && i < n-1 && s >= 0 && s < ns) {
+            m_z[i-1][s] = vars[k];
+            ++nz;
+         }
+      } else if (sscanf(name, "b(%d,%d)", &i, &s) == 2) {
+         if (i >= 1 && i < n-1 && s >= 0 && s < ns)
+            m_svcStart[i * ns + s] = vars[k];
+      } else if (string(name) == "tmax") {
+         m_Tmax = vars[k];
+         ++ntmax;
+      }
+   }
+
+   // Rebuild `m_xSeq` in the same order used by `build`, and make sure the
+   // cached model has exactly the variables `build` would create.
+   int expectedX = 0;
+   for (int i = 0; i < n - 1; ++i) {
+      for (int j = 0; j < n - 1; ++j) {
+         for (int v = 0; v < nv; ++v) {
+            for (int s = 0; s < ns; ++s) {
+               if (!hasVarX(i, j, v, s))
                   continue;
+               ++expectedX;
+               if (m_x[i][j][v][s].getImpl()) {
+                  addActiveX(m_x[i][j][v][s], v);
+               }
+            }
+         }
+      }
+   }
 
-               if (j != 0) {
-                  if (m_inst.nodeReqSkill(j, s) == 0) {
-                     continue;
-                  }
-                  if (m_inst.vehicleHasSkill(v, s) == 0) {
-                     continue;
+   // Rebind the constraint handles, also by name.
+   map <tuple<int,int,int,int,int>, SyncCons> syncs;
+   int ndepot = 0;
+   for (IloInt k = 0; k < rngs.getSize(); ++k) {
+      const char *name = rngs[k].getName();
+      int i, v, v2, s, s2;
+      if (!name) {
+         continue;
+      } else if (sscanf(name, "depot_src(%d)", &v) == 1) {
+         if (v >= 0 && v < nv) {
+            m_depotSrc[v] = rngs[k];
+            ++ndepot;
+         }
+      } else if (sscanf(name, "depot_sink(%d)", &v) == 1) {
+         if (v >= 0 && v < nv) {
+            m_depotSink[v] = rngs[k];
+            ++ndepot;
+         }
+      } else if (sscanf(name, "flow_conserv(%d,%d)", &i, &v) == 2) {
+         if (i >= 1 && i < n-1 && v >= 0 && v < nv)
+            m_flowCons[i * nv + v] = rngs[k];
+      } else if (sscanf(name, "svc_attendance(%d,%d)", &i, &s) == 2) {
+         if (i >= 1 && i < n-1 && s >= 0 && s < ns)
+            m_assignCons[i * ns + s] = rngs[k];
+      } else if (sscanf(name, "tw_end(%d,%d,%d)", &i, &v, &s) == 3) {
+         if (i >= 1 && i < n-1 && v >= 0 && v < nv && s >= 0 && s < ns)
+            m_twEndCons[(i * nv + v) * ns + s] = rngs[k];
+      } else if (sscanf(name, "sync_link_a(%d,%d,%d)", &i, &v, &s) == 3) {
+         if (i >= 1 && i < n-1 && v >= 0 && v < nv && s >= 0 && s < ns)
+            m_svcLinks[((i * nv + v) * ns + s) * 2] = rngs[k];
+      } else if (sscanf(name, "sync_link_b(%d,%d,%d)", &i, &v, &s) == 3) {
+         if (i >= 1 && i < n-1 && v >= 0 && v < nv && s >= 0 && s < ns)
+            m_svcLinks[((i * nv + v) * ns + s) * 2 + 1] = rngs[k];
+      } else if (sscanf(name, "sync_a(%d,%d,%d,%d,%d)", &i, &v, &v2, &s, &s2) == 5) {
+         SyncCons &sync = syncs[make_tuple(i, v, v2, s, s2)];
+         sync.i = i; sync.v1 = v; sync.v2 = v2; sync.s1 = s; sync.s2 = s2;
+         sync.a = rngs[k];
+      } else if (sscanf(name, "sync_b(%d,%d,%d,%d,%d)", &i, &v, &v2, &s, &s2) == 5) {
+         SyncCons &sync = syncs[make_tuple(i, v, v2, s, s2)];
+         sync.i = i; sync.v1 = v; sync.v2 = v2; sync.s1 = s; sync.s2 = s2;
+         sync.b = rngs[k];
+      }
+   }
+   for (const auto &entry: syncs)
+      m_syncCons.push_back(entry.second);
+
+   if (nx != expectedX || m_xSeq.getSize() != expectedX || ntmax != 1 || nt == 0 || nz == 0 || ndepot != 2 * nv) {
+      cout << "MipModel: model cache " << path << " does not match the instance; rebuilding it." << endl;
+      m_xSeq.clear();
+      m_xSeqVehicle.clear();
+      for (IloNumVarArray &arcs: m_vehicleX)
+         arcs.clear();
+      allocateVars();
+      m_model.end();
+      m_cplex.end();
+      return false;
+   }
+
+   m_model.setName("routing_cost");
+   m_cplex.extract(m_model);
+   return true;
+}
+
+bool MipModel::hasVarX(int i, int j, int v, int s) const {
+   // Does not create unnecessary variables.
+   // Remove all variables which represent unfeasible assignment of
+   // tasks, but keep all arcs departing from /arriving to the depot.
+   if (i == j && j != 0)
+      return false;
+
+   if (j != 0) {
+      if (m_inst.nodeReqSkill(j, s) == 0)
+         return false;
+      if (m_inst.vehicleHasSkill(v, s) == 0)
+         return false;
+   }
+
+   return true;
+}
+
+void MipModel::build() {
+   // Basic CPLEX variables.
+   m_model = IloModel(m_env);
+   m_cplex = IloCplex(m_model);
+   m_model.setName("routing_cost");
+
+   m_buildTimes.clear();
+   auto timed = [this] (const char *family, void (MipModel::*create)()) {
+      // Only called by the constructor, so the destructor will not release
+      // the environment.
+      if (m_cancel && m_cancel->load()) {
+         m_env.end();
+         throw BuildCancelled();
+      }
+      auto t0 = chrono::steady_clock::now();
+      (this->*create)();
+      auto t1 = chrono::steady_clock::now();
+      m_buildTimes.push_back(make_pair(string(family), chrono::duration<double>(t1 - t0).count()));
+   };
+
+   timed("variables", &MipModel::createVariables);
+   timed("tardiness (4)", &MipModel::createTardinessConstraints);
+   timed("depot (5)", &MipModel::createDepotConstraints);
+   timed("flow (6)", &MipModel::createFlowConstraints);
+   timed("assignment (7)", &MipModel::createAssignmentConstraints);
+   timed("subcycle (8)", &MipModel::createSubcycleConstraints);
+   timed("tw end (10)", &MipModel::createTwEndConstraints);
+   timed(m_formulation == Formulation::VEHICLE ? "sync (11-12)" : "sync (aggregated)", &MipModel::createSyncConstraints);
+
+   // Implements (13).
+   // It is not strictly necessary since such variables are removed from the problem.
+   #if 0
+   int bcount = 0;
+   for (int i = 0 ; i < m_inst.numNodes()-1; ++i) {
+      for (int j = 0; j < m_inst.numNodes()-1; ++j) {
+         for (int v = 0; v < m_inst.numVehicles(); ++v) {
+            for (int s = 0; s < m_inst.numSkills(); ++s) {
+               if (m_x[i][j][v][s].getImpl()) {
+                  IloConstraint c = m_x[i][j][v][s] <= m_inst.nodeReqSkill(j, s) * m_inst.vehicleHasSkill(v, s);
+                  m_model.add(c);
+                  if (m_inst.nodeReqSkill(j, s) * m_inst.vehicleHasSkill(v, s) <= 0) {
+                     cout << "Creating (13) -> " << i << "," << j << "," << v << "," << s << endl;
+                     cout << "  Has demand? = " << m_inst.nodeReqSkill(j, s) << endl;
+                     cout << "  Has qualification? = " << m_inst.vehicleHasSkill(v, s) << endl;
+                     ++bcount;
                   }
                }
+            }
+         }
+      }
+   }
+   cout << "I had to create " << bcount << " (13)-constraints.\n";
+   #endif
+}
+
+void MipModel::createVariables() {
+   IloExpr expr(m_env);
+   char buf[128] = "";
+
+   // Maximum tardiness variable.
+   m_Tmax = IloNumVar(m_env, 0., IloInfinity, IloNumVar::Float, "tmax");
+
+   // Create decision variables x.
+   for (int i = 0; i < m_inst.numNodes() - 1; ++i) {
+      for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
+         for (int v = 0; v < m_inst.numVehicles(); ++v) {
+            for (int s = 0; s < m_inst.numSkills(); ++s) {
+               if (!hasVarX(i, j, v, s))
+                  continue;
 
                snprintf(buf, sizeof buf, "x(%d,%d,%d,%d)", i, j, v, s);
                m_x[i][j][v][s] = IloNumVar(m_env, 0.0, 1.0, IloNumVar::Bool, buf);
-               m_xSeq.add(m_x[i][j][v][s]);
+               addActiveX(m_x[i][j][v][s], v);
 
                // Embeds Constraints (2).
                expr += L1 * m_inst.distance(i, j) * m_x[i][j][v][s];
@@ -90,10 +382,7 @@ MipModel::MipModel(const Instance &inst): m_inst(inst) {
    }
 
    // Create aux variables z.
-   m_z = Var2D(m_env, m_inst.numNodes() - 2);
    for (int i = 1; i < m_inst.numNodes() - 1; ++i) {
-      m_z[i-1] = Var1D(m_env, m_inst.numSkills());
-
       for (int s = 0; s < m_inst.numSkills(); ++s) {
          if (m_inst.nodeReqSkill(i, s) == 0)
             continue;
@@ -107,13 +396,8 @@ MipModel::MipModel(const Instance &inst): m_inst(inst) {
    }
 
    // Create aux variables t.
-   m_t = Var3D(m_env, m_inst.numNodes() - 1);
    for (int i = 0; i < m_inst.numNodes() - 1; ++i) {
-      m_t[i] = Var2D(m_env, m_inst.numVehicles());
-
       for (int v = 0; v < m_inst.numVehicles(); ++v) {
-         m_t[i][v] = Var1D(m_env, m_inst.numSkills());
-
          for (int s = 0; s < m_inst.numSkills(); ++s) {
 
             // Does not generate unneeded variables.
@@ -135,7 +419,12 @@ MipModel::MipModel(const Instance &inst): m_inst(inst) {
    expr += L3 * m_Tmax;
    m_obj = IloObjective(m_env, expr, IloObjective::Minimize, "routingCost");
    m_model.add(m_obj);
-   expr.clear();
+
+   expr.end();
+}
+
+void MipModel::createTardinessConstraints() {
+   char buf[128] = "";
 
    // Create (4) greatest tardiness constraints.
    for (int i = 1; i < m_inst.numNodes() - 1; ++i) {
@@ -150,6 +439,11 @@ MipModel::MipModel(const Instance &inst): m_inst(inst) {
          m_model.add(c);
       }
    }
+}
+
+void MipModel::createDepotConstraints() {
+   IloExpr expr(m_env);
+   char buf[128] = "";
 
    // Create (5-1) flow on source node.
    for (int v = 0; v < m_inst.numVehicles(); ++v) {
@@ -159,10 +453,11 @@ MipModel::MipModel(const Instance &inst): m_inst(inst) {
                expr += m_x[0][i][v][s];
          }
       }
-      IloConstraint c = expr == 1;
+      IloRange c = expr == 1;
       snprintf(buf, sizeof buf, "depot_src(%d)", v);
       c.setName(buf);
       m_model.add(c);
+      m_depotSrc[v] = c;
       expr.clear();
    }
 
@@ -174,192 +469,455 @@ MipModel::MipModel(const Instance &inst): m_inst(inst) {
             expr += m_x[i][0][v][s];
          }
       }
-      IloConstraint c = expr == 1;
+      IloRange c = expr == 1;
       snprintf(buf, sizeof buf, "depot_sink(%d)", v);
       c.setName(buf);
       m_model.add(c);
+      m_depotSink[v] = c;
       expr.clear();
    }
 
+   expr.end();
+}
+
+void MipModel::createFlowConstraints() {
    // Create (6) flow conservation constraints.
-   for (int i = 1; i < m_inst.numNodes() - 1; ++i) {
+   for (int i = 1; i < m_inst.numNodes() - 1; ++i)
+      createFlowConstraints(i);
+}
+
+void MipModel::createFlowConstraints(int i) {
+   IloExpr expr(m_env);
+   char buf[128] = "";
+
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
+         for (int s = 0; s < m_inst.numSkills(); ++s) {
+            if (m_x[j][i][v][s].getImpl())
+               expr += m_x[j][i][v][s];
+            if (m_x[i][j][v][s].getImpl())
+               expr -= m_x[i][j][v][s];
+         }
+      }
+      IloRange c = expr == 0;
+      snprintf(buf, sizeof buf, "flow_conserv(%d,%d)", i, v);
+      c.setName(buf);
+      m_model.add(c);
+      m_flowCons[i * m_inst.numVehicles() + v] = c;
+      expr.clear();
+   }
+
+   expr.end();
+}
+
+void MipModel::createAssignmentConstraints() {
+   // Create (7) assignment constraints.
+   for (int i = 1; i < m_inst.numNodes() - 1; ++i)
+      createAssignmentConstraints(i);
+}
+
+void MipModel::createAssignmentConstraints(int i) {
+   IloExpr expr(m_env);
+   char buf[128] = "";
+
+   for (int s = 0; s < m_inst.numSkills(); ++s) {
+
+      if (!m_inst.nodeReqSkill(i, s))
+         continue;
+
       for (int v = 0; v < m_inst.numVehicles(); ++v) {
          for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
-            for (int s = 0; s < m_inst.numSkills(); ++s) {
-               if (m_x[j][i][v][s].getImpl())
-                  expr += m_x[j][i][v][s];
-               if (m_x[i][j][v][s].getImpl())
-                  expr -= m_x[i][j][v][s];
-            }
+            if (m_x[j][i][v][s].getImpl())
+               expr += m_x[j][i][v][s];
          }
-         IloConstraint c = expr == 0;
-         snprintf(buf, sizeof buf, "flow_conserv(%d,%d)", i, v);
-         c.setName(buf);
-         m_model.add(c);
-         expr.clear();
       }
+      // The demand is kept as the right-hand side, so that it can be
+      // changed later on (see `deactivateNode`).
+      IloRange c = expr == m_inst.nodeReqSkill(i, s);
+      snprintf(buf, sizeof buf, "svc_attendance(%d,%d)", i, s);
+      c.setName(buf);
+      m_model.add(c);
+      m_assignCons[i * m_inst.numSkills() + s] = c;
+      expr.clear();
    }
 
-   // Create (7) assignment constraints.
-   for (int i = 1; i < m_inst.numNodes() - 1; ++i) {
+   expr.end();
+}
+
+void MipModel::createSubcycleConstraints() {
+   // Create (8) subcycle elimination constraints.
+   for (int i = 0; i < m_inst.numNodes() - 1; ++i)
+      for (int j = 1; j < m_inst.numNodes() - 1; ++j)
+         createSubcycleConstraints(i, j);
+}
+
+void MipModel::createSubcycleConstraints(int i, int j) {
+   IloExpr expr(m_env);
+   char buf[128] = "";
+
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      for (int s1 = 0; s1 < m_inst.numSkills(); ++s1) {
+         for (int s2 = 0; s2 < m_inst.numSkills(); ++s2) {
+
+            if (m_x[i][j][v][s2].getImpl() == nullptr)
+               continue;
+            if (m_t[i][v][s1].getImpl() == nullptr)
+               continue;
+            if (m_t[j][v][s2].getImpl() == nullptr)
+               continue;
+
+            expr += m_t[i][v][s1];
+            expr += m_inst.nodeProcTime(i, s1);
+            expr += m_inst.distance(i, j);
+            expr -= m_t[j][v][s2];
+            expr -= bigM;
+            expr += bigM * m_x[i][j][v][s2];
+
+            IloConstraint c = expr <= 0;
+            snprintf(buf, 128, "subcycle_elim(%d,%d,%d,%d,%d)", i, j, v, s1, s2);
+            c.setName(buf);
+            m_model.add(c);
+            expr.clear();
+         }
+      }
+   }
+
+   expr.end();
+}
+
+void MipModel::createTwEndConstraints() {
+   // Create (10) end time window constraints.
+   for (int i = 1; i < m_inst.numNodes() - 1; ++i)
+      createTwEndConstraints(i);
+}
+
+void MipModel::createTwEndConstraints(int i) {
+   char buf[128] = "";
+
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
       for (int s = 0; s < m_inst.numSkills(); ++s) {
 
-         if (!m_inst.nodeReqSkill(i, s))
+         if (m_z[i-1][s].getImpl() == nullptr)
+            continue;
+         if (m_t[i][v][s].getImpl() == nullptr)
             continue;
 
-         for (int v = 0; v < m_inst.numVehicles(); ++v) {
-            for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
-               if (m_x[j][i][v][s].getImpl())
-                  expr += m_x[j][i][v][s];
-            }
-         }
-         expr -= m_inst.nodeReqSkill(i, s);
-         IloConstraint c = expr == 0;
-         snprintf(buf, sizeof buf, "svc_attendance(%d,%d)", i, s);
+         // The end of the time window is kept as the right-hand side, so that
+         // it can be changed later on (see `updateTimeWindow`).
+         IloRange c = m_t[i][v][s] - m_z[i-1][s] <= m_inst.nodeTwMax(i);
+         snprintf(buf, 128, "tw_end(%d,%d,%d)", i, v, s);
          c.setName(buf);
          m_model.add(c);
-         expr.clear();
+         m_twEndCons[(i * m_inst.numVehicles() + v) * m_inst.numSkills() + s] = c;
       }
    }
+}
 
-   // Create (8) subcycle elimination constraints.
-   for (int i = 0; i < m_inst.numNodes() - 1; ++i) {
-      for (int j = 1; j < m_inst.numNodes() - 1; ++j) {
-         for (int v = 0; v < m_inst.numVehicles(); ++v) {
-            for (int s1 = 0; s1 < m_inst.numSkills(); ++s1) {
-               for (int s2 = 0; s2 < m_inst.numSkills(); ++s2) {
-
-                  if (m_x[i][j][v][s2].getImpl() == nullptr)
-                     continue;
-                  if (m_t[i][v][s1].getImpl() == nullptr)
-                     continue;
-                  if (m_t[j][v][s2].getImpl() == nullptr)
-                     continue;
-
-                  expr += m_t[i][v][s1];
-                  expr += m_inst.nodeProcTime(i, s1);
-                  expr += m_inst.distance(i, j);
-                  expr -= m_t[j][v][s2];
-                  expr -= bigM;
-                  expr += bigM * m_x[i][j][v][s2];
-
-                  IloConstraint c = expr <= 0;
-                  snprintf(buf, 128, "subcycle_elim(%d,%d,%d,%d,%d)", i, j, v, s1, s2);
+void MipModel::createSyncConstraints() {
+   // Create the synchronization constraints.
+   for (int i = 1; i < m_inst.numNodes() - 1; ++i)
+      createSyncConstraints(i);
+}
+
+void MipModel::createSyncConstraints(int i) {
+   IloExpr expr(m_env);
+   char buf[128] = "";
+
+   if (m_inst.nodeSvcType(i) != Instance::SIM && m_inst.nodeSvcType(i) != Instance::PRED)
+      return;
+
+   if (m_formulation == Formulation::AGGREGATED) {
+      expr.end();
+      createAggregatedSyncConstraints(i);
+      return;
+   }
+
+   for (int v1 = 0; v1 < m_inst.numVehicles(); ++v1) {
+      for (int v2 = 0; v2 < m_inst.numVehicles(); ++v2) {
+         for (int s2 = 0; s2 < m_inst.numSkills(); ++s2) {
+            for (int s1 = 0; s1 < s2; ++s1) {
+               if (m_t[i][v2][s2].getImpl() == nullptr)
+                  continue;
+               if (m_t[i][v1][s1].getImpl() == nullptr)
+                  continue;
+
+               SyncCons sync;
+               sync.i = i;
+               sync.v1 = v1;
+               sync.v2 = v2;
+               sync.s1 = s1;
+               sync.s2 = s2;
+
+               // Create (11).
+               {
+                  expr += m_t[i][v2][s2];
+                  expr -= m_t[i][v1][s1];
+                  expr -= m_inst.nodeDeltaMin(i);
+                  expr += 2 * bigM;
+
+                  for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
+                     if (m_x[j][i][v1][s1].getImpl())
+                        expr -= bigM * m_x[j][i][v1][s1];
+                     if (m_x[j][i][v2][s2].getImpl())
+                        expr -= bigM * m_x[j][i][v2][s2];
+                  }
+
+                  IloRange c = expr >= 0;
+                  snprintf(buf, sizeof buf, "sync_a(%d,%d,%d,%d,%d)", i, v1, v2, s1, s2);
                   c.setName(buf);
                   m_model.add(c);
+                  sync.a = c;
                   expr.clear();
                }
+
+               // Create (12).
+               {
+                  expr += m_t[i][v2][s2];
+                  expr -= m_t[i][v1][s1];
+                  expr -= m_inst.nodeDeltaMax(i);
+                  expr -= 2 * bigM;
+
+                  for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
+                     if (m_x[j][i][v1][s1].getImpl())
+                        expr += bigM * m_x[j][i][v1][s1];
+                     if (m_x[j][i][v2][s2].getImpl())
+                        expr += bigM * m_x[j][i][v2][s2];
+                  }
+
+                  IloRange c = expr <= 0;
+                  snprintf(buf, sizeof buf, "sync_b(%d,%d,%d,%d,%d)", i, v1, v2, s1, s2);
+                  c.setName(buf);
+                  m_model.add(c);
+                  sync.b = c;
+                  expr.clear();
+               }
+
+               m_syncCons.push_back(sync);
             }
          }
       }
    }
 
-   // Create (10) end time window constraints.
-   for (int i = 1; i < m_inst.numNodes() - 1; ++i) {
-      for (int v = 0; v < m_inst.numVehicles(); ++v) {
-         for (int s = 0; s < m_inst.numSkills(); ++s) {
+   expr.end();
+}
 
-            if (m_z[i-1][s].getImpl() == nullptr)
-               continue;
-            if (m_t[i][v][s].getImpl() == nullptr)
-               continue;
+void MipModel::createAggregatedSyncConstraints(int i) {
+   const int nv = m_inst.numVehicles(), ns = m_inst.numSkills();
+   IloExpr expr(m_env);
+   char buf[128] = "";
+
+   for (int s = 0; s < ns; ++s) {
+      if (!m_inst.nodeReqSkill(i, s))
+         continue;
+
+      snprintf(buf, sizeof buf, "b(%d,%d)", i, s);
+      IloNumVar &b = m_svcStart[i * ns + s];
+      b = IloNumVar(m_env, m_inst.nodeTwMin(i), IloInfinity, IloNumVar::Float, buf);
+
+      // b equals the start time of the vehicle that provides the service:
+      // |t(i,v,s) - b(i,s)| <= M (1 - sum_j x(j,i,v,s)).
+      for (int v = 0; v < nv; ++v) {
+         if (m_t[i][v][s].getImpl() == nullptr)
+            continue;
 
-            IloConstraint c = m_t[i][v][s] - m_inst.nodeTwMax(i) - m_z[i-1][s] <= 0;
-            snprintf(buf, 128, "tw_end(%d,%d,%d)", i, v, s);
+         IloExpr arrivals(m_env);
+         for (int j = 0; j < m_inst.numNodes() - 1; ++j)
+            if (m_x[j][i][v][s].getImpl())
+               arrivals += bigM * m_x[j][i][v][s];
+
+         for (int k = 0; k < 2; ++k) {
+            expr += k == 0 ? m_t[i][v][s] - b : b - m_t[i][v][s];
+            expr += arrivals;
+
+            IloRange c = expr <= bigM;
+            snprintf(buf, sizeof buf, k == 0 ? "sync_link_a(%d,%d,%d)" : "sync_link_b(%d,%d,%d)", i, v, s);
             c.setName(buf);
             m_model.add(c);
+            m_svcLinks[((i * nv + v) * ns + s) * 2 + k] = c;
+            expr.clear();
          }
+         arrivals.end();
       }
    }
 
-   // Create the synchronization constraints.
-   for (int i = 1, cc = 1; i < m_inst.numNodes() - 1; ++i) {
-      if (m_inst.nodeSvcType(i) != Instance::SIM && m_inst.nodeSvcType(i) != Instance::PRED)
-         continue;
+   // (11) and (12) on the start times of the services.
+   for (int s2 = 0; s2 < ns; ++s2) {
+      for (int s1 = 0; s1 < s2; ++s1) {
+         if (!m_svcStart[i * ns + s1].getImpl() || !m_svcStart[i * ns + s2].getImpl())
+            continue;
 
-      for (int v1 = 0; v1 < m_inst.numVehicles(); ++v1) {
-         for (int v2 = 0; v2 < m_inst.numVehicles(); ++v2) {
-            for (int s2 = 0; s2 < m_inst.numSkills(); ++s2) {
-               for (int s1 = 0; s1 < s2; ++s1, ++cc) {
-                  if (m_t[i][v2][s2].getImpl() == nullptr)
-                     continue;
-                  if (m_t[i][v1][s1].getImpl() == nullptr)
-                     continue;
-
-                  // Create (11).
-                  {
-                     expr += m_t[i][v2][s2];
-                     expr -= m_t[i][v1][s1];
-                     expr -= m_inst.nodeDeltaMin(i);
-                     expr += 2 * bigM;
-
-                     for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
-                        if (m_x[j][i][v1][s1].getImpl())
-                           expr -= bigM * m_x[j][i][v1][s1];
-                        if (m_x[j][i][v2][s2].getImpl())
-                           expr -= bigM * m_x[j][i][v2][s2];
-                     }
-
-                     IloConstraint c = expr >= 0;
-                     snprintf(buf, sizeof buf, "sync_a(%d,%d,%d,%d,%d)", i, v1, v2, s1, s2);
-                     c.setName(buf);
-                     m_model.add(c);
-                     expr.clear();
-                  }
+         expr += m_svcStart[i * ns + s2];
+         expr -= m_svcStart[i * ns + s1];
+         IloRange c(m_env, m_inst.nodeDeltaMin(i), expr, m_inst.nodeDeltaMax(i));
+         snprintf(buf, sizeof buf, "sync(%d,%d,%d)", i, s1, s2);
+         c.setName(buf);
+         m_model.add(c);
+         expr.clear();
+      }
+   }
 
-                  // Create (12).
-                  {
-                     expr += m_t[i][v2][s2];
-                     expr -= m_t[i][v1][s1];
-                     expr -= m_inst.nodeDeltaMax(i);
-                     expr -= 2 * bigM;
-
-                     for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
-                        if (m_x[j][i][v1][s1].getImpl())
-                           expr += bigM * m_x[j][i][v1][s1];
-                        if (m_x[j][i][v2][s2].getImpl())
-                           expr += bigM * m_x[j][i][v2][s2];
-                     }
-
-                     IloConstraint c = expr <= 0;
-                     snprintf(buf, sizeof buf, "sync_b(%d,%d,%d,%d,%d)", i, v1, v2, s1, s2);
-                     c.setName(buf);
-                     m_model.add(c);
-                     expr.clear();
-                  }
-               }
-            }
+   expr.end();
+}
+
+void MipModel::updateTimeWindow(int i) {
+   const int nv = m_inst.numVehicles(), ns = m_inst.numSkills();
+   m_lpValid = false;
+   restoreRemovedArcs();
+   releaseStartTimes();
+   clearIncumbentBounds();
+   for (int v = 0; v < nv; ++v) {
+      for (int s = 0; s < ns; ++s) {
+         if (m_t[i][v][s].getImpl())
+            m_t[i][v][s].setLb(m_inst.nodeTwMin(i));
+         IloRange &c = m_twEndCons[(i * nv + v) * ns + s];
+         if (c.getImpl())
+            c.setUB(m_inst.nodeTwMax(i));
+      }
+   }
+   for (int s = 0; s < ns; ++s)
+      if (m_svcStart[i * ns + s].getImpl())
+         m_svcStart[i * ns + s].setLb(m_inst.nodeTwMin(i));
+}
+
+void MipModel::deactivateNode(int i) {
+   m_lpValid = false;
+   restoreRemovedArcs();
+   releaseStartTimes();
+   clearIncumbentBounds();
+   // No visit is required anymore, so flow conservation keeps every arc
+   // of node i at zero, and the constraints of its visits become inactive.
+   for (int s = 0; s < m_inst.numSkills(); ++s) {
+      IloRange &c = m_assignCons[i * m_inst.numSkills() + s];
+      if (c.getImpl())
+         c.setBounds(0.0, 0.0);
+   }
+}
+
+void MipModel::addNode() {
+   const int k = m_inst.numNodes() - 2;
+   const int nv = m_inst.numVehicles(), ns = m_inst.numSkills();
+   assert(m_x.getSize() == k && "Instance must have exactly one new patient.");
+
+   m_lpValid = false;
+   restoreRemovedArcs();
+   releaseStartTimes();
+   clearIncumbentBounds();
+
+   // Grow the variable arrays.
+   for (int i = 0; i < k; ++i) {
+      m_x[i].add(Var2D(m_env, nv));
+      for (int v = 0; v < nv; ++v)
+         m_x[i][k][v] = Var1D(m_env, ns);
+   }
+   m_x.add(Var3D(m_env, k+1));
+   for (int j = 0; j <= k; ++j) {
+      m_x[k][j] = Var2D(m_env, nv);
+      for (int v = 0; v < nv; ++v)
+         m_x[k][j][v] = Var1D(m_env, ns);
+   }
+   m_z.add(Var1D(m_env, ns));
+   m_t.add(Var2D(m_env, nv));
+   for (int v = 0; v < nv; ++v)
+      m_t[k][v] = Var1D(m_env, ns);
+
+   m_flowCons.resize((k+1) * nv);
+   m_assignCons.resize((k+1) * ns);
+   m_twEndCons.resize((k+1) * nv * ns);
+   m_svcStart.resize((k+1) * ns);
+   m_svcLinks.resize(2 * (k+1) * nv * ns);
+
+   // Variables of the new node, as in `createVariables`.
+   char buf[128] = "";
+   auto newX = [&] (int i, int j, int v, int s) {
+      snprintf(buf, sizeof buf, "x(%d,%d,%d,%d)", i, j, v, s);
+      m_x[i][j][v][s] = IloNumVar(m_env, 0.0, 1.0, IloNumVar::Bool, buf);
+      addActiveX(m_x[i][j][v][s], v);
+      m_obj.setLinearCoef(m_x[i][j][v][s], L1 * m_inst.distance(i, j));
+   };
+   for (int i = 0; i <= k; ++i) {
+      for (int v = 0; v < nv; ++v) {
+         for (int s = 0; s < ns; ++s) {
+            if (i < k && hasVarX(i, k, v, s))
+               newX(i, k, v, s);
+            if (hasVarX(k, i, v, s))
+               newX(k, i, v, s);
          }
       }
    }
 
-   // Implements (13).
-   // It is not strictly necessary since such variables are removed from the problem.
-   #if 0
-   int bcount = 0;
-   for (int i = 0 ; i < inst.numNodes()-1; ++i) {
-      for (int j = 0; j < inst.numNodes()-1; ++j) {
-         for (int v = 0; v < inst.numVehicles(); ++v) {
-            for (int s = 0; s < inst.numSkills(); ++s) {
-               if (m_x[i][j][v][s].getImpl()) {
-                  IloConstraint c = m_x[i][j][v][s] <= m_inst.nodeReqSkill(j, s) * m_inst.vehicleHasSkill(v, s);
-                  m_model.add(c);
-                  if (m_inst.nodeReqSkill(j, s) * m_inst.vehicleHasSkill(v, s) <= 0) {
-                     cout << "Creating (13) -> " << i << "," << j << "," << v << "," << s << endl;
-                     cout << "  Has demand? = " << m_inst.nodeReqSkill(j, s) << endl;
-                     cout << "  Has qualification? = " << m_inst.vehicleHasSkill(v, s) << endl;
-                     ++bcount;
-                  }
-               }
+   for (int s = 0; s < ns; ++s) {
+      if (m_inst.nodeReqSkill(k, s) == 0)
+         continue;
+
+      snprintf(buf, sizeof buf, "z(%d,%d)", k, s);
+      m_z[k-1][s] = IloNumVar(m_env, 0., IloInfinity, IloNumVar::Float, buf);
+      m_obj.setLinearCoef(m_z[k-1][s], L2);
+
+      // Constraint (4).
+      IloConstraint c = m_Tmax - m_z[k-1][s] >= 0;
+      snprintf(buf, sizeof buf, "tmax(%d,%d)", k, s);
+      c.setName(buf);
+      m_model.add(c);
+
+      for (int v = 0; v < nv; ++v) {
+         if (m_inst.vehicleHasSkill(v, s) == 0)
+            continue;
+         snprintf(buf, sizeof buf, "t(%d,%d,%d)", k, v, s);
+         m_t[k][v][s] = IloNumVar(m_env, m_inst.nodeTwMin(k), IloInfinity, IloNumVar::Float, buf);
+      }
+   }
+
+   // Arcs of the new node into existing constraints: (5), (6), (7), (11) and
+   // (12) (or the links of the aggregated formulation).
+   for (int v = 0; v < nv; ++v) {
+      for (int s = 0; s < ns; ++s) {
+         if (m_x[0][k][v][s].getImpl())
+            m_depotSrc[v].setLinearCoef(m_x[0][k][v][s], 1.0);
+         if (m_x[k][0][v][s].getImpl())
+            m_depotSink[v].setLinearCoef(m_x[k][0][v][s], 1.0);
+      }
+   }
+   for (int i = 1; i < k; ++i) {
+      for (int v = 0; v < nv; ++v) {
+         for (int s = 0; s < ns; ++s) {
+            if (m_x[k][i][v][s].getImpl()) {
+               m_flowCons[i * nv + v].setLinearCoef(m_x[k][i][v][s], 1.0);
+               if (m_assignCons[i * ns + s].getImpl())
+                  m_assignCons[i * ns + s].setLinearCoef(m_x[k][i][v][s], 1.0);
+            }
+            if (m_x[i][k][v][s].getImpl())
+               m_flowCons[i * nv + v].setLinearCoef(m_x[i][k][v][s], -1.0);
+            for (int l = 0; l < 2; ++l) {
+               IloRange &link = m_svcLinks[((i * nv + v) * ns + s) * 2 + l];
+               if (link.getImpl() && m_x[k][i][v][s].getImpl())
+                  link.setLinearCoef(m_x[k][i][v][s], bigM);
             }
          }
       }
    }
-   cout << "I had to create " << bcount << " (13)-constraints.\n";
-   #endif
+   for (SyncCons &sync: m_syncCons) {
+      const IloNumVar &x1 = m_x[k][sync.i][sync.v1][sync.s1];
+      const IloNumVar &x2 = m_x[k][sync.i][sync.v2][sync.s2];
+      if (x1.getImpl()) {
+         sync.a.setLinearCoef(x1, -bigM);
+         sync.b.setLinearCoef(x1, bigM);
+      }
+      if (x2.getImpl()) {
+         sync.a.setLinearCoef(x2, -bigM);
+         sync.b.setLinearCoef(x2, bigM);
+      }
+   }
 
-   // Release helper objects.
-   expr.end();
+   // Constraints of the new node.
+   createFlowConstraints(k);
+   createAssignmentConstraints(k);
+   for (int i = 0; i <= k; ++i) {
+      createSubcycleConstraints(i, k);
+      if (i != k && i != 0)
+         createSubcycleConstraints(k, i);
+   }
+   createTwEndConstraints(k);
+   createSyncConstraints(k);
 }
 
 MipModel::~MipModel() {
@@ -370,6 +928,18 @@ const Instance & MipModel::instance() const {
    return m_inst;
 }
 
+bool MipModel::fromCache() const {
+   return m_fromCache;
+}
+
+MipModel::Formulation MipModel::formulation() const {
+   return m_formulation;
+}
+
+const std::vector <std::pair<std::string, double>> &MipModel::buildTimes() const {
+   return m_buildTimes;
+}
+
 void MipModel::setQuiet(bool toggle) {
    if (toggle) {
       m_cplex.setOut(m_env.getNullStream());
@@ -378,6 +948,15 @@ void MipModel::setQuiet(bool toggle) {
    }
 }
 
+MipModel::ModelStats MipModel::modelStats() const {
+   ModelStats stats;
+   stats.variables = long(m_cplex.getNcols());
+   stats.constraints = long(m_cplex.getNrows());
+   stats.nonzeros = long(m_cplex.getNNZs());
+   stats.envBytes = long(m_env.getMemoryUsage());
+   return stats;
+}
+
 void MipModel::writeLp(const char *fname) {
    m_cplex.exportModel(fname);
 }
@@ -394,55 +973,452 @@ void MipModel::timeLimit(int maxSeconds) {
    m_cplex.setParam(IloCplex::NumParam::TiLim, maxSeconds);
 }
 
+void MipModel::detTimeLimit(double ticks) {
+   m_cplex.setParam(IloCplex::NumParam::DetTiLim, ticks > 0.0 ? ticks : 1e75);
+}
+
+void MipModel::cutoff(double value) {
+   m_cplex.setParam(IloCplex::NumParam::CutUp, value);
+}
+
 void MipModel::setVarX(int i, int j, int v, int s, double lb, double ub) {
    assert(m_x[i][j][v][s].getImpl() && "Trying to set bounds of unexisting variable.");
    m_x[i][j][v][s].setBounds(lb, ub);
 }
 
-void MipModel::fixCurrentSolution() {
+void MipModel::setRoutes(const vector <vector <pair<int, int>>> &routes) {
+   IloNumVarArray arcs(m_env);
+   for (int v = 0; v < int(routes.size()); ++v) {
+      int prevNode = 0;
+      int prevSkill = 0;
+      for (const auto &visit: routes[v]) {
+         arcs.add(m_x[prevNode][visit.first][v][visit.second]);
+         prevNode = visit.first;
+         prevSkill = visit.second;
+      }
+      arcs.add(m_x[prevNode][0][v][prevSkill]);
+   }
+
+   IloNumArray ones(m_env, arcs.getSize());
+   for (IloInt k = 0; k < arcs.getSize(); ++k)
+      ones[k] = 1.0;
+   arcs.setBounds(ones, ones);
+
+   ones.end();
+   arcs.end();
+}
+
+void MipModel::fixCurrentSolution(const vector <int> &fixedTimes) {
    m_cplex.getValues(m_solXSeq, m_xSeq);
-   for (IloInt i = 0; i < m_xSeq.getSize(); ++i) {
-      m_xSeq[i].setBounds(m_solXSeq[i], m_solXSeq[i]);
+
+   IloNumVarArray times(m_env);
+   IloNumArray values(m_env), lb(m_env), ub(m_env);
+   for (int v: fixedTimes)
+      vehicleTimes(v, times, lb, ub);
+   if (times.getSize() > 0)
+      m_cplex.getValues(values, times);
+
+   // The model is only modified once the solution is read.
+   releaseStartTimes();
+   m_xSeq.setBounds(m_solXSeq, m_solXSeq);
+   if (times.getSize() > 0)
+      times.setBounds(values, values);
+   for (int v: fixedTimes)
+      m_timeFixed[v] = 1;
+
+   times.end();
+   values.end();
+   lb.end();
+   ub.end();
+}
+
+void MipModel::vehicleTimes(int v, IloNumVarArray &vars, IloNumArray &lb, IloNumArray &ub) const {
+   for (int i = 0; i < int(m_t.getSize()); ++i) {
+      const double tMax = i == 0 || m_tardinessBound == numeric_limits<double>::infinity() ? IloInfinity :
+         m_inst.nodeTwMax(i) + m_tardinessBound;
+      for (int s = 0; s < m_inst.numSkills(); ++s) {
+         if (!m_t[i][v][s].getImpl())
+            continue;
+         vars.add(m_t[i][v][s]);
+         lb.add(m_inst.nodeTwMin(i));
+         ub.add(tMax);
+      }
    }
 }
 
+void MipModel::releaseStartTimes() {
+   IloNumVarArray times(m_env);
+   IloNumArray lb(m_env), ub(m_env);
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      if (m_timeFixed[v])
+         vehicleTimes(v, times, lb, ub);
+      m_timeFixed[v] = 0;
+   }
+   if (times.getSize() > 0)
+      times.setBounds(lb, ub);
+
+   times.end();
+   lb.end();
+   ub.end();
+}
+
 void MipModel::unfixSolution() {
-   for (int i = 0; i < m_inst.numNodes() - 1; ++i) {
-      for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
+   restoreRemovedArcs();
+   releaseStartTimes();
+   clearIncumbentBounds();
+   unfixActive();
+}
+
+void MipModel::unfixActive() {
+   IloNumArray lb(m_env, m_xSeq.getSize());
+   IloNumArray ub(m_env, m_xSeq.getSize());
+   for (IloInt k = 0; k < m_xSeq.getSize(); ++k)
+      ub[k] = 1.0;
+   m_xSeq.setBounds(lb, ub);
+
+   lb.end();
+   ub.end();
+}
+
+int MipModel::unfixVehicleSolution(int v) {
+   IloNumVarArray &arcs = m_vehicleX[v];
+   IloNumArray lb(m_env, arcs.getSize());
+   IloNumArray ub(m_env, arcs.getSize());
+   for (IloInt k = 0; k < arcs.getSize(); ++k)
+      ub[k] = 1.0;
+   arcs.setBounds(lb, ub);
+
+   lb.end();
+   ub.end();
+   return int(arcs.getSize());
+}
+
+int MipModel::unfixArcsAmong(const vector <int> &nodes) {
+   vector <int> ends(nodes);
+   ends.push_back(0);
+   sort(ends.begin(), ends.end());
+   ends.erase(unique(ends.begin(), ends.end()), ends.end());
+
+   IloNumVarArray arcs(m_env);
+   for (int i: ends) {
+      for (int j: ends) {
          for (int v = 0; v < m_inst.numVehicles(); ++v) {
             for (int s = 0; s < m_inst.numSkills(); ++s) {
-               if (m_x[i][j][v][s].getImpl()) {
-                  m_x[i][j][v][s].setBounds(0.0, 1.0);
-               }
+               const IloNumVar &x = m_x[i][j][v][s];
+               if (x.getImpl() && !m_removedImpl.count(x.getImpl()))
+                  arcs.add(x);
             }
          }
       }
    }
+
+   IloNumArray lb(m_env, arcs.getSize());
+   IloNumArray ub(m_env, arcs.getSize());
+   for (IloInt k = 0; k < arcs.getSize(); ++k)
+      ub[k] = 1.0;
+   arcs.setBounds(lb, ub);
+
+   const int count = int(arcs.getSize());
+   arcs.end();
+   lb.end();
+   ub.end();
+   return count;
 }
 
-int MipModel::unfixVehicleSolution(int v) {
-   int xcount = 0;
-   for (int i = 0; i < m_inst.numNodes() - 1; ++i) {
-      for (int j = 0; j < m_inst.numNodes() - 1; ++j) {
-         for (int s = 0; s < m_inst.numSkills(); ++s) {
-            if (m_x[i][j][v][s].getImpl()) {
-               m_x[i][j][v][s].setBounds(0.0, 1.0);
-               ++xcount;
-            }
-         }
+void MipModel::addActiveX(const IloNumVar &x, int v) {
+   m_xSeq.add(x);
+   m_xSeqVehicle.push_back(v);
+   m_vehicleX[v].add(x);
+}
+
+int MipModel::removeArcsByReducedCost(double incumbentObj) {
+   // The arcs of the incumbent are read by `fixCurrentSolution`.
+   if (!m_lpValid || m_solXSeq.getSize() != m_xSeq.getSize())
+      return 0;
+
+   // An arc at zero in the relaxation raises its bound by its reduced cost
+   // when used; if that exceeds the incumbent, no better solution uses it.
+   // The tolerance is relative, as the big-M rows make the reduced costs
+   // noisy, and arcs of the incumbent are kept regardless, so it remains
+   // feasible.
+   const double gap = incumbentObj - m_lpObj;
+   const double tol = 1e-6 * max(1.0, fabs(incumbentObj));
+   vector <char> remove(m_xSeq.getSize(), 0);
+   int count = 0;
+   for (IloInt k = 0; k < m_xSeq.getSize(); ++k) {
+      if (m_solXSeq[k] < 0.5 && m_lpX[k] <= 1e-6 && m_lpRc[k] > gap + tol) {
+         remove[k] = 1;
+         ++count;
       }
    }
-   return xcount;
+   if (count == 0)
+      return 0;
+
+   // Compact the active arcs (and the relaxation and the incumbent, which
+   // follow them).
+   IloNumVarArray xSeq(m_env), removed(m_env);
+   IloNumArray lpX(m_env), lpRc(m_env), solXSeq(m_env);
+   vector <int> xSeqVehicle;
+   for (IloNumVarArray &arcs: m_vehicleX)
+      arcs.clear();
+   for (IloInt k = 0; k < m_xSeq.getSize(); ++k) {
+      const int v = m_xSeqVehicle[k];
+      if (remove[k]) {
+         removed.add(m_xSeq[k]);
+         m_removedX.add(m_xSeq[k]);
+         m_removedVehicle.push_back(v);
+         m_removedImpl.insert(m_xSeq[k].getImpl());
+         m_removedLpX.add(m_lpX[k]);
+         m_removedLpRc.add(m_lpRc[k]);
+      } else {
+         xSeq.add(m_xSeq[k]);
+         lpX.add(m_lpX[k]);
+         lpRc.add(m_lpRc[k]);
+         solXSeq.add(m_solXSeq[k]);
+         xSeqVehicle.push_back(v);
+         m_vehicleX[v].add(m_xSeq[k]);
+      }
+   }
+
+   IloNumArray zeros(m_env, removed.getSize());
+   removed.setBounds(zeros, zeros);
+   zeros.end();
+   removed.end();
+
+   m_xSeq.end();
+   m_lpX.end();
+   m_lpRc.end();
+   m_solXSeq.end();
+   m_xSeq = xSeq;
+   m_lpX = lpX;
+   m_lpRc = lpRc;
+   m_solXSeq = solXSeq;
+   m_xSeqVehicle.swap(xSeqVehicle);
+
+   return count;
 }
 
-double MipModel::solve() {
-   if (!m_cplex.solve()) {
-      cout << "MipModel::solve(): Problem become infeasible." << endl;
-      exit(EXIT_FAILURE);
+void MipModel::restoreRemovedArcs() {
+   if (m_removedX.getSize() == 0)
+      return;
+
+   // The restored arcs are appended to the active ones, and so are their
+   // values in the relaxation, which thus remains valid: it was solved
+   // before they were removed.
+   const bool keepLp = m_lpValid && m_lpX.getSize() == m_xSeq.getSize() &&
+      m_removedLpX.getSize() == m_removedX.getSize();
+
+   IloNumArray lb(m_env, m_removedX.getSize());
+   IloNumArray ub(m_env, m_removedX.getSize());
+   for (IloInt k = 0; k < m_removedX.getSize(); ++k) {
+      ub[k] = 1.0;
+      addActiveX(m_removedX[k], m_removedVehicle[k]);
+      if (keepLp) {
+         m_lpX.add(m_removedLpX[k]);
+         m_lpRc.add(m_removedLpRc[k]);
+      }
    }
+   m_removedX.setBounds(lb, ub);
+   lb.end();
+   ub.end();
+   m_removedX.clear();
+   m_removedVehicle.clear();
+   m_removedImpl.clear();
+   m_removedLpX.clear();
+   m_removedLpRc.clear();
+
+   if (!keepLp)
+      m_lpValid = false;
+}
+
+int MipModel::numActiveArcs() const {
+   return int(m_xSeq.getSize());
+}
+
+double MipModel::propagateIncumbent(double incumbentObj) {
+   // A small slack keeps the incumbent itself feasible despite rounding.
+   const double obj = incumbentObj + 1e-4 + 1e-9 * fabs(incumbentObj);
+   if (obj < m_propagatedObj) {
+      m_propagatedObj = obj;
+      m_tardinessBound = max(0.0, (obj - L1 * minDistance()) / (L2 + L3));
+      setTardinessBound(m_tardinessBound);
+   }
+   return m_tardinessBound;
+}
+
+void MipModel::clearIncumbentBounds() {
+   if (m_propagatedObj == numeric_limits<double>::infinity())
+      return;
+   m_propagatedObj = m_tardinessBound = numeric_limits<double>::infinity();
+   setTardinessBound(IloInfinity);
+}
+
+double MipModel::minDistance() const {
+   double dist = 0.0;
+   for (int i = 1; i < m_inst.numNodes() - 1; ++i) {
+      double cheapest = numeric_limits<double>::infinity();
+      for (int j = 0; j < m_inst.numNodes() - 1; ++j)
+         if (j != i)
+            cheapest = min(cheapest, m_inst.distance(j, i));
+      for (int s = 0; s < m_inst.numSkills(); ++s)
+         if (m_inst.nodeReqSkill(i, s))
+            dist += cheapest;
+   }
+   return dist;
+}
+
+void MipModel::setTardinessBound(double zMax) {
+   const int nv = m_inst.numVehicles(), ns = m_inst.numSkills();
+   IloNumVarArray vars(m_env);
+   IloNumArray lb(m_env), ub(m_env);
+   auto add = [&] (const IloNumVar &var, double l, double u) {
+      vars.add(var);
+      lb.add(l);
+      ub.add(u);
+   };
+
+   // Sized by the variables, since `addNode` calls it before they grow.
+   add(m_Tmax, 0.0, zMax);
+   for (int i = 1; i < int(m_t.getSize()); ++i) {
+      const double tMax = zMax == IloInfinity ? IloInfinity : m_inst.nodeTwMax(i) + zMax;
+      for (int s = 0; s < ns; ++s) {
+         if (m_z[i-1][s].getImpl())
+            add(m_z[i-1][s], 0.0, zMax);
+         if (m_svcStart[i * ns + s].getImpl())
+            add(m_svcStart[i * ns + s], m_inst.nodeTwMin(i), tMax);
+         for (int v = 0; v < nv; ++v)
+            if (m_t[i][v][s].getImpl() && !m_timeFixed[v])
+               add(m_t[i][v][s], m_inst.nodeTwMin(i), tMax);
+      }
+   }
+   vars.setBounds(lb, ub);
+
+   vars.end();
+   lb.end();
+   ub.end();
+}
+
+void MipModel::setSymmetryCut(int v, int w) {
+   assert(m_inst.vehicleClass(v) == m_inst.vehicleClass(w) && "Vehicles are not interchangeable.");
+   clearSymmetryCut();
+
+   if (!m_symCut.getImpl()) {
+      m_symCut = IloRange(m_env, 0.0, IloInfinity, "symmetry");
+      m_model.add(m_symCut);
+   }
+   for (int j = 1; j < m_inst.numNodes() - 1; ++j) {
+      for (int s = 0; s < m_inst.numSkills(); ++s) {
+         if (m_x[0][j][v][s].getImpl())
+            m_symCut.setLinearCoef(m_x[0][j][v][s], j);
+         if (m_x[0][j][w][s].getImpl())
+            m_symCut.setLinearCoef(m_x[0][j][w][s], -j);
+      }
+   }
+   m_symPair[0] = v;
+   m_symPair[1] = w;
+}
+
+void MipModel::clearSymmetryCut() {
+   if (m_symPair[0] == -1)
+      return;
+
+   for (int k = 0; k < 2; ++k)
+      for (int j = 1; j < m_inst.numNodes() - 1; ++j)
+         for (int s = 0; s < m_inst.numSkills(); ++s)
+            if (m_x[0][j][m_symPair[k]][s].getImpl())
+               m_symCut.setLinearCoef(m_x[0][j][m_symPair[k]][s], 0.0);
+   m_symPair[0] = m_symPair[1] = -1;
+}
+
+int MipModel::firstVisit(int v) const {
+   for (int j = 1; j < m_inst.numNodes() - 1; ++j)
+      for (int s = 0; s < m_inst.numSkills(); ++s)
+         if (m_x[0][j][v][s].getImpl() && m_cplex.getValue(m_x[0][j][v][s]) >= 0.5)
+            return j;
+   return 0;
+}
+
+bool MipModel::solveRelaxation() {
+   // Both instances share the bounds, so the current solution is unfixed
+   // while the relaxation is solved.
+   // The relaxation bounds the whole model, so the symmetry cut is released
+   // as well.
+   m_cplex.getValues(m_solXSeq, m_xSeq);
+   clearSymmetryCut();
+   releaseStartTimes();
+   unfixActive();
+
+   // The LP instance is only kept for this solve; otherwise every later
+   // bound change would also be applied to it, and it would hold a second
+   // copy of the model.
+   IloModel lpModel(m_env);
+   IloConversion relax(m_env, m_xSeq, IloNumVar::Float);
+   lpModel.add(m_model);
+   lpModel.add(relax);
+   IloCplex lpCplex(lpModel);
+   lpCplex.setOut(m_env.getNullStream());
+   lpCplex.setWarning(m_env.getNullStream());
+   lpCplex.setParam(IloCplex::IntParam::Threads, 1);
+   lpCplex.setParam(IloCplex::NumParam::TiLim, m_cplex.getParam(IloCplex::NumParam::TiLim));
+
+   m_lpValid = lpCplex.solve() && lpCplex.getCplexStatus() == IloCplex::Optimal;
+   if (m_lpValid) {
+      m_lpObj = lpCplex.getObjValue();
+      lpCplex.getValues(m_lpX, m_xSeq);
+      lpCplex.getReducedCosts(m_lpRc, m_xSeq);
+   }
+
+   lpCplex.end();
+   relax.end();
+   lpModel.end();
+
+   m_xSeq.setBounds(m_solXSeq, m_solXSeq);
+   if (!trySolve())
+      throw runtime_error("MipModel::solveRelaxation(): Current solution could not be restored.");
+   return m_lpValid;
+}
+
+bool MipModel::hasRelaxation() const {
+   return m_lpValid;
+}
+
+vector <double> MipModel::relaxationDistances() const {
+   vector <double> dist(m_inst.numVehicles(), 0.0);
+   if (!m_lpValid)
+      return dist;
+
+   IloNumArray current(m_env);
+   m_cplex.getValues(current, m_xSeq);
+   for (IloInt k = 0; k < m_xSeq.getSize(); ++k)
+      dist[m_xSeqVehicle[k]] += fabs(m_lpX[k] - current[k]);
+   current.end();
+
+   return dist;
+}
+
+double MipModel::solve() {
+   if (!trySolve())
+      throw runtime_error("MipModel::solve(): Problem become infeasible.");
    return m_cplex.getObjValue();
 }
 
+bool MipModel::trySolve() {
+   if (!m_cplex.solve())
+      return false;
+
+   const IloCplex::CplexStatus status = m_cplex.getCplexStatus();
+   m_lastSolve.nodes = long(m_cplex.getNnodes());
+   m_lastSolve.iterations = long(m_cplex.getNiterations());
+   m_lastSolve.gap = m_cplex.getMIPRelativeGap();
+   m_lastSolve.timeLimitHit = status == IloCplex::AbortTimeLim || status == IloCplex::AbortDetTimeLim;
+
+   return true;
+}
+
+const MipModel::SolveStats &MipModel::lastSolve() const {
+   return m_lastSolve;
+}
+
 double MipModel::objValue() const {
    return m_cplex.getObjValue();
 }
@@ -455,6 +1431,20 @@ double MipModel::objLb() const {
    return m_cplex.getBestObjValue();
 }
 
+double MipModel::provenBound(bool &complete) const {
+   const IloCplex::CplexStatus status = m_cplex.getCplexStatus();
+   const double cut = m_cplex.getParam(IloCplex::NumParam::CutUp);
+   complete = status == IloCplex::Optimal || status == IloCplex::OptimalTol || status == IloCplex::Infeasible;
+   if (status == IloCplex::Infeasible)
+      return cut;
+
+   try {
+      return min(m_cplex.getBestObjValue(), cut);
+   } catch (IloException &e) {
+      return -numeric_limits<double>::infinity();
+   }
+}
+
 double MipModel::serviceStartTime(int i, int v, int s) const {
    for (int j = 0; j < m_inst.numNodes()-1; ++j) {
       if (m_x[j][i][v][s].getImpl() && m_cplex.getValue(m_x[j][i][v][s]) >= 0.8) {
@@ -463,3 +1453,38 @@ double MipModel::serviceStartTime(int i, int v, int s) const {
    }
    return numeric_limits<double>::infinity();
 }
+
+double MipModel::tardiness(int i, int s) const {
+   if (!m_z[i-1][s].getImpl())
+      return 0.0;
+   return m_cplex.getValue(m_z[i-1][s]);
+}
+
+vector <vector <pair<int, int>>> MipModel::routes() const {
+   vector <vector <pair<int, int>>> result(m_inst.numVehicles());
+   const int maxLen = (m_inst.numNodes() - 1) * m_inst.numSkills();
+
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      int curr = 0;
+      do {
+         int next = 0;
+         int nextSkill = -1;
+         for (int j = 0; j < m_inst.numNodes()-1 && nextSkill == -1; ++j) {
+            for (int s = 0; s < m_inst.numSkills(); ++s) {
+               if (m_x[curr][j][v][s].getImpl() && m_cplex.getValue(m_x[curr][j][v][s]) >= 0.5) {
+                  next = j;
+                  nextSkill = s;
+                  break;
+               }
+            }
+         }
+         if (nextSkill == -1 || next == 0)
+            break;
+
+         result[v].push_back(make_pair(next, nextSkill));
+         curr = next;
+      } while (int(result[v].size()) <= maxLen);
+   }
+
+   return result;
+}
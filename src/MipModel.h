@@ -29,11 +29,26 @@
 
 #include "Instance.h"
 
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #define IL_STD
 #include <ilcplex/ilocplex.h>
 
 class MipModel {
 public:
+   /** Thrown by the constructor when the build is cancelled. */
+   class BuildCancelled: public std::runtime_error {
+   public:
+      BuildCancelled(): std::runtime_error("MipModel: build cancelled.") {
+         // Empty
+      }
+   };
+
    /**
     * Lambda values from obj function.
     * L1: Distance weight
@@ -44,6 +59,51 @@ public:
    constexpr const static double L2 = 1./3.;
    constexpr const static double L3 = 1./3.;
 
+   /** Big-M constant of constraints (8), (11) and (12) (and of the links of the aggregated formulation). */
+   constexpr const static double bigM = 1e6;
+
+   /**
+    * Statistics of a call to `solve`: branch-and-bound nodes, simplex
+    * iterations, relative MIP gap at exit and whether the (wall-clock or
+    * deterministic) time limit stopped the search.
+    */
+   struct SolveStats {
+      long nodes = 0;
+      long iterations = 0;
+      double gap = 0.0;
+      bool timeLimitHit = false;
+   };
+
+   /**
+    * Size of the model as extracted by CPLEX, and memory (in bytes) held by
+    * its Concert environment.
+    */
+   struct ModelStats {
+      long variables = 0;
+      long constraints = 0;
+      long nonzeros = 0;
+      long envBytes = 0;
+   };
+
+   /**
+    * Formulations of the synchronization of double services.
+    * VEHICLE: constraints (11) and (12) for every pair of vehicles that may
+    *    provide the two services of a node, relaxed by big-M terms on the
+    *    arcs into the node.
+    * AGGREGATED: one start time variable per service of the node, linked to
+    *    the start time of each vehicle that may provide it (big-M on the arcs
+    *    of that vehicle only), and a single range on their difference. The
+    *    number of nonzeros grows with V instead of V^2.
+    */
+   enum class Formulation {
+      VEHICLE = 0,
+      AGGREGATED,
+      MAX_
+   };
+
+   static const char *formulationName(Formulation formulation);
+   static bool parseFormulation(const char *name, Formulation &formulation);
+
    /** Shortcuts to define multi-dimensional variables. */
    using Var1D = IloArray <IloNumVar>;
    using Var2D = IloArray <Var1D>;
@@ -51,10 +111,29 @@ public:
    using Var4D = IloArray <Var3D>;
 
 
-   MipModel(const Instance &inst);
+   /**
+    * Creates the MIP model of `inst`. If `cacheDir` is given, the model is
+    * imported from a CPLEX SAV file of that directory, keyed by the content
+    * hash of the instance (and the formulation), instead of being built;
+    * the file is written when it does not exist yet.
+    * If `cancel` is given, it is checked between the families of the build,
+    * which throws `BuildCancelled` once it is set.
+    */
+   MipModel(const Instance &inst, const std::string &cacheDir = "", Formulation formulation = Formulation::VEHICLE,
+      const std::atomic <bool> *cancel = nullptr);
    virtual ~MipModel();
 
    const Instance &instance() const;
+   bool fromCache() const;
+   Formulation formulation() const;
+
+   /**
+    * Time (in seconds) spent creating each family of variables/constraints
+    * by the last model construction. Empty if the model was loaded from cache.
+    */
+   const std::vector <std::pair<std::string, double>> &buildTimes() const;
+
+   ModelStats modelStats() const;
 
    void setQuiet(bool toggle);
    void writeLp(const char *fname);
@@ -63,20 +142,174 @@ public:
    void maxThreads(int value);
    void timeLimit(int maxSeconds);
 
+   /**
+    * Deterministic time limit of each solve, in CPLEX ticks. Unlike the
+    * wall-clock limit, runs stopped by it are reproducible in the same
+    * machine and CPLEX version. Non-positive values disable it.
+    */
+   void detTimeLimit(double ticks);
+
+   /**
+    * Upper cutoff of the search: solutions not better than `value` are
+    * discarded, and so are the nodes that can not lead to a better one.
+    */
+   void cutoff(double value);
+
    void setVarX(int i, int j, int v, int s, double lb, double ub);
-   void fixCurrentSolution();
+
+   /**
+    * Fixes the arcs of the routes (as given by `routes`) to one, in a single
+    * bulk update. The routes must be valid (see `validateRoutes`).
+    */
+   void setRoutes(const std::vector <std::vector <std::pair<int, int>>> &routes);
+   /**
+    * Fixes the arcs of the current solution. The start times of the
+    * vehicles in `fixedTimes` are fixed as well, so the subproblem neither
+    * reroutes nor reschedules them; the start times fixed by a previous
+    * call are released first.
+    */
+   void fixCurrentSolution(const std::vector <int> &fixedTimes = {});
+
+   /** Frees every arc, including the ones removed by `removeArcsByReducedCost`. */
    void unfixSolution();
    int unfixVehicleSolution(int v);
 
+   /**
+    * Frees the arcs, of every vehicle, between the nodes of `nodes` and the
+    * depot, in a single bulk update; the rest of the routes keep the bounds
+    * set by `fixCurrentSolution`. Arcs removed by reduced-cost fixing stay
+    * removed. Returns the number of arcs freed.
+    */
+   int unfixArcsAmong(const std::vector <int> &nodes);
+
+   /** Throws `std::runtime_error` if no solution is found. */
    double solve();
+
+   /**
+    * Same as `solve`, but returns false when no solution is found, instead
+    * of throwing.
+    */
+   bool trySolve();
+
+   const SolveStats &lastSolve() const;
    double objValue() const;
    double relativeGap() const;
    double objLb() const;
 
+   /**
+    * Lower bound proven by the last solve, even if it found no solution:
+    * the best bound of the open nodes, or the cutoff if the search proved
+    * that no better solution exists. `complete` tells whether the search
+    * finished. Returns -infinity if no bound is available.
+    */
+   double provenBound(bool &complete) const;
+
    double serviceStartTime(int i, int v, int s) const;
 
+   /** Tardiness of the service of skill `s` at patient `i` in the current solution; 0 if not required. */
+   double tardiness(int i, int s) const;
+
+   /**
+    * Routes of the current solution: for each vehicle, the (node, skill)
+    * pairs it visits, in order, excluding the depot.
+    */
+   std::vector <std::vector <std::pair<int, int>>> routes() const;
+
+   /**
+    * Incremental updates, applied after the instance changes (see
+    * `Reoptimizer`). They modify the extracted model in place instead of
+    * building it again.
+    * updateTimeWindow: node `i` has a new time window.
+    * deactivateNode: node `i` no longer requires any visit.
+    * addNode: the instance has one more patient, at index `numNodes()-2`.
+    */
+   void updateTimeWindow(int i);
+   void deactivateNode(int i);
+   void addNode();
+
+   /**
+    * Symmetry breaking between two interchangeable vehicles (see
+    * `Instance::vehicleClass`): the first patient visited by `v` must have
+    * an index not smaller than the one of `w` (see `firstVisit`). Only one
+    * pair is ordered at a time; setting another pair, or clearing the cut,
+    * releases the previous one.
+    */
+   void setSymmetryCut(int v, int w);
+   void clearSymmetryCut();
+
+   /**
+    * Index of the first patient visited by vehicle `v` in the current
+    * solution; 0 if its route is empty.
+    */
+   int firstVisit(int v) const;
+
+   /**
+    * LP relaxation of the whole model, with no arc fixed. It is solved by a
+    * second CPLEX instance, which shares the variables and constraints of
+    * the model but relaxes the integrality of `x`, and is released as soon
+    * as the solution is read. The relaxation does not depend on the current
+    * solution, so its values are kept until the instance changes. The bounds of `x` are restored to the
+    * current solution, which is solved again so it remains readable.
+    * Returns false if the relaxation could not be solved within the time
+    * limit of the model; throws `std::runtime_error` if the current
+    * solution can not be restored.
+    */
+   bool solveRelaxation();
+   bool hasRelaxation() const;
+
+   /**
+    * For each vehicle, the distance between the arcs of the relaxation and
+    * of the current solution: sum over its arcs of |x_lp - x|. Vehicles far
+    * from the relaxation are the ones it would reroute the most.
+    */
+   std::vector <double> relaxationDistances() const;
+
+   /**
+    * Reduced-cost fixing: removes (fixes to zero) every arc that is at zero
+    * in the relaxation and whose reduced cost exceeds the gap between
+    * `incumbentObj` and the relaxation bound, since no solution better than
+    * the incumbent can use it. Arcs of the incumbent, as read by the last
+    * `fixCurrentSolution`, are never removed. Removed arcs leave the active
+    * arcs, so the fix/unfix passes and the solution reads no longer touch
+    * them. Does nothing if the relaxation is not available. Returns the
+    * number of arcs removed.
+    * The arcs are restored by `unfixSolution`, which keeps the relaxation,
+    * and by the incremental updates, which invalidate it.
+    */
+   int removeArcsByReducedCost(double incumbentObj);
+   void restoreRemovedArcs();
+   int numActiveArcs() const;
+
+   /**
+    * Bound propagation from the incumbent: every required service has an
+    * incoming arc, so the distance term is at least the sum of their
+    * cheapest incoming arcs (Dmin), and since Tmax >= z, no solution with
+    * objective up to `incumbentObj` has any tardiness above
+    * (incumbentObj - L1 * Dmin) / (L2 + L3). That bounds `Tmax`, every `z`,
+    * and the start times (`t`, and the service start times of the
+    * aggregated formulation) by the end of their time window plus it.
+    * Only tightens: calls with a worse incumbent than a previous one do
+    * nothing. Returns the tardiness bound in effect.
+    * The bounds are released by `unfixSolution` and by the incremental
+    * updates, after which the incumbent may no longer satisfy them.
+    */
+   double propagateIncumbent(double incumbentObj);
+   void clearIncumbentBounds();
+
 protected:
+   /**
+    * Version of the formulation written by `build`. Must be increased
+    * whenever `build` changes (variables, constraint names or bounds), to
+    * invalidate model caches; `load` only checks names and counts.
+    * 2: named time-window and assignment ranges, for the incremental updates.
+    * 3: aggregated start-time variables of the synchronization.
+    */
+   static const int modelCacheVersion = 3;
+
    const Instance &m_inst;
+   bool m_fromCache;
+   Formulation m_formulation;
+   const std::atomic <bool> *m_cancel;
 
    IloEnv m_env;
    IloModel m_model;
@@ -89,8 +322,93 @@ protected:
    Var3D m_t;
    Var4D m_x;
 
+   /** Active arcs: all arcs of the model but the ones removed by reduced-cost fixing. */
    IloNumVarArray m_xSeq;
    IloNumArray m_solXSeq;
+   std::vector <int> m_xSeqVehicle;
+   std::vector <IloNumVarArray> m_vehicleX;
+
+   IloNumVarArray m_removedX;
+   std::vector <int> m_removedVehicle;
+   std::unordered_set <IloNumVarI*> m_removedImpl;
+
+   /** Relaxation values of the removed arcs, restored along with them. */
+   IloNumArray m_removedLpX;
+   IloNumArray m_removedLpRc;
+
+   /** LP relaxation (see `solveRelaxation`); values and reduced costs follow `m_xSeq`. */
+   IloNumArray m_lpX;
+   IloNumArray m_lpRc;
+   double m_lpObj;
+   bool m_lpValid;
+
+   /** Vehicles whose start times are fixed by `fixCurrentSolution`. */
+   std::vector <char> m_timeFixed;
+
+   /** Incumbent (plus slack) and tardiness bound of the last `propagateIncumbent`; infinity if none. */
+   double m_propagatedObj;
+   double m_tardinessBound;
+
+   std::vector <std::pair<std::string, double>> m_buildTimes;
+   SolveStats m_lastSolve;
+
+   /**
+    * Handles of the constraints touched by incremental updates, indexed by
+    * node (depot constraints: by vehicle).
+    */
+   struct SyncCons {
+      int i, v1, v2, s1, s2;
+      IloRange a, b;
+   };
+   std::vector <IloRange> m_depotSrc;
+   std::vector <IloRange> m_depotSink;
+   std::vector <IloRange> m_flowCons;
+   std::vector <IloRange> m_assignCons;
+   std::vector <IloRange> m_twEndCons;
+   std::vector <SyncCons> m_syncCons;
+
+   /**
+    * Aggregated formulation: start time of each service, indexed by
+    * node * S + skill, and its two links to the start time of each vehicle,
+    * indexed by ((node * V + vehicle) * S + skill) * 2 + (0: t - b, 1: b - t).
+    */
+   std::vector <IloNumVar> m_svcStart;
+   std::vector <IloRange> m_svcLinks;
+
+   IloRange m_symCut;
+   int m_symPair[2];
+
+   void allocateVars();
+   bool hasVarX(int i, int j, int v, int s) const;
+   void addActiveX(const IloNumVar &x, int v);
+   void unfixActive();
+   void setTardinessBound(double zMax);
+
+   /** Start time variables of vehicle `v`, and the bounds they have when not fixed. */
+   void vehicleTimes(int v, IloNumVarArray &vars, IloNumArray &lb, IloNumArray &ub) const;
+   void releaseStartTimes();
+
+   /** Sum, over the required services, of the cheapest arc into their node. */
+   double minDistance() const;
+   void build();
+   bool load(const std::string &path);
+
+   void createVariables();
+   void createTardinessConstraints();
+   void createDepotConstraints();
+   void createFlowConstraints();
+   void createAssignmentConstraints();
+   void createSubcycleConstraints();
+   void createTwEndConstraints();
+   void createSyncConstraints();
+
+   /** Constraints of a single node (subcycle: of a single arc). */
+   void createFlowConstraints(int i);
+   void createAssignmentConstraints(int i);
+   void createSubcycleConstraints(int i, int j);
+   void createTwEndConstraints(int i);
+   void createSyncConstraints(int i);
+   void createAggregatedSyncConstraints(int i);
 };
 
 
@@ -0,0 +1,194 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Reoptimizer.h"
+#include "FixAndOptimize.h"
+#include "MemoryUsage.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+
+using namespace std;
+
+
+Reoptimizer::Reoptimizer(Instance &inst, MipModel &model): m_inst(inst), m_model(model) {
+   m_routes = m_model.routes();
+}
+
+Reoptimizer::~Reoptimizer() {
+   // Empty
+}
+
+void Reoptimizer::changeTimeWindow(int node, double twMin, double twMax) {
+   markVehiclesVisiting(node);
+   m_inst.setNodeTw(node, twMin, twMax);
+   m_model.updateTimeWindow(node);
+}
+
+void Reoptimizer::cancelPatient(int node) {
+   markVehiclesVisiting(node);
+   for (auto &route: m_routes) {
+      route.erase(remove_if(route.begin(), route.end(), [node] (const pair<int, int> &visit) {
+         return visit.first == node;
+      }), route.end());
+   }
+   m_inst.cancelPatient(node);
+   m_model.deactivateNode(node);
+}
+
+int Reoptimizer::addPatient(const Instance::Patient &patient) {
+   const int node = m_inst.addPatient(patient);
+   m_model.addNode();
+
+   // Each service of the patient goes to a different vehicle.
+   set <int> used;
+   for (int s = 0; s < m_inst.numSkills(); ++s) {
+      if (!m_inst.nodeReqSkill(node, s))
+         continue;
+      insertVisit(node, s, used);
+      for (int v = 0; v < m_inst.numVehicles(); ++v)
+         for (const auto &visit: m_routes[v])
+            if (visit.first == node)
+               used.insert(v);
+   }
+
+   return node;
+}
+
+bool Reoptimizer::reoptimize(const RunSettings &settings, RunResult &res) {
+   m_model.setQuiet(true);
+   m_model.maxThreads(1);
+   m_model.timeLimit(settings.maxIterSeconds);
+   m_model.detTimeLimit(settings.maxIterTicks);
+
+   // Evaluate the repaired routes. If they are not feasible anymore, let the
+   // affected vehicles be routed from scratch.
+   setRoutes(false);
+   if (!m_model.trySolve()) {
+      if (settings.verbose)
+         cout << "Repaired routes are infeasible; rerouting affected vehicles." << endl;
+      setRoutes(true);
+      if (!m_model.trySolve())
+         return false;
+   }
+   if (settings.verbose)
+      cout << "Repaired plan cost: " << m_model.objValue() << "." << endl;
+
+   vector <int> focus(m_affected.begin(), m_affected.end());
+   const int maxIterNoImpr = settings.maxIterNoImpr >= 0 ? settings.maxIterNoImpr : max(2, 2 * int(focus.size()));
+
+   unique_ptr <FixAndOptimize> feoSolver(new FixAndOptimize(m_model));
+   feoSolver->setVerbose(settings.verbose);
+   feoSolver->setTrace(settings.trace);
+   feoSolver->setProgress(settings.progress);
+   feoSolver->setTimeBudget(settings.maxSeconds);
+   feoSolver->setSymmetryBreaking(settings.symmetryBreaking);
+   feoSolver->setDecompositions(settings.decompositions);
+   feoSolver->setReducedCostFixing(settings.reducedCostFixing);
+   feoSolver->setBoundPropagation(settings.boundPropagation);
+   feoSolver->setPartnerTiming(settings.partnerTiming);
+   feoSolver->setFocus(focus);
+   feoSolver->solve(settings.seed, maxIterNoImpr, settings.maxIterSeconds);
+
+   res.instance = m_inst.fileName();
+   res.seed = settings.seed;
+   res.timeBest = feoSolver->timeBest();
+   res.timeTotal = feoSolver->timeTotal();
+   res.cost = m_model.objValue();
+   res.trajectory = feoSolver->trajectory();
+   res.memInstance = long(m_inst.memoryBytes() / 1024);
+   res.rssSearch = peakRssKb();
+
+   m_routes = m_model.routes();
+   m_affected.clear();
+   return true;
+}
+
+const set <int> &Reoptimizer::affectedVehicles() const {
+   return m_affected;
+}
+
+void Reoptimizer::markVehiclesVisiting(int node) {
+   for (int v = 0; v < int(m_routes.size()); ++v)
+      for (const auto &visit: m_routes[v])
+         if (visit.first == node)
+            m_affected.insert(v);
+}
+
+void Reoptimizer::insertVisit(int node, int skill, const set <int> &excluded) {
+   int bestVehicle = -1;
+   size_t bestPos = 0;
+   double bestCost = numeric_limits<double>::infinity();
+
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      if (!m_inst.vehicleHasSkill(v, skill) || excluded.count(v))
+         continue;
+
+      const auto &route = m_routes[v];
+      for (size_t pos = 0; pos <= route.size(); ++pos) {
+         const int prev = pos == 0 ? 0 : route[pos-1].first;
+         const int next = pos == route.size() ? 0 : route[pos].first;
+         const double cost = m_inst.distance(prev, node) + m_inst.distance(node, next) - m_inst.distance(prev, next);
+         if (cost < bestCost) {
+            bestCost = cost;
+            bestVehicle = v;
+            bestPos = pos;
+         }
+      }
+   }
+
+   if (bestVehicle == -1) {
+      cout << "Reoptimizer: no vehicle available for skill " << skill << " of node " << node << "." << endl;
+      return;
+   }
+
+   m_routes[bestVehicle].insert(m_routes[bestVehicle].begin() + bestPos, make_pair(node, skill));
+   m_affected.insert(bestVehicle);
+}
+
+void Reoptimizer::setRoutes(bool affectedOnly) {
+   m_model.unfixSolution();
+
+   // Same as `solutionCopy`: fix the arcs of the routes.
+   for (int v = 0; v < m_inst.numVehicles(); ++v) {
+      if (affectedOnly && m_affected.count(v))
+         continue;
+
+      int prevNode = 0;
+      int prevSkill = 0;
+      for (const auto &visit: m_routes[v]) {
+         m_model.setVarX(prevNode, visit.first, v, visit.second, 1.0, 1.0);
+         prevNode = visit.first;
+         prevSkill = visit.second;
+      }
+      m_model.setVarX(prevNode, 0, v, prevSkill, 1.0, 1.0);
+   }
+}
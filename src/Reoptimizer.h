@@ -0,0 +1,87 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "Instance.h"
+#include "MipModel.h"
+#include "ResultsLog.h"
+#include "Runner.h"
+
+#include <set>
+#include <utility>
+#include <vector>
+
+/**
+ * Incremental re-optimization of a plan after changes in the instance:
+ * patients added or cancelled, and time windows changed.
+ *
+ * Changes are applied in place to the loaded instance and to its MIP model.
+ * The current routes are repaired (cancelled visits are dropped, new ones
+ * are placed by cheapest insertion), and `reoptimize` runs a short
+ * fix-and-optimize whose decompositions always free a vehicle affected by
+ * the changes.
+ */
+class Reoptimizer {
+public:
+   /**
+    * `model` is the model of `inst`, holding the solution of the current plan.
+    */
+   Reoptimizer(Instance &inst, MipModel &model);
+   virtual ~Reoptimizer();
+
+   void changeTimeWindow(int node, double twMin, double twMax);
+   void cancelPatient(int node);
+
+   /**
+    * Adds a patient and inserts its visits into the routes. Returns the
+    * index of the new node.
+    */
+   int addPatient(const Instance::Patient &patient);
+
+   /**
+    * Re-optimizes the plan after the changes. `settings.maxIterNoImpr` < 0
+    * stops after twice the number of affected vehicles without improvement.
+    * Returns false if no feasible plan was found.
+    */
+   bool reoptimize(const RunSettings &settings, RunResult &res);
+
+   const std::set <int> &affectedVehicles() const;
+
+private:
+   Instance &m_inst;
+   MipModel &m_model;
+
+   /** Visits (node, skill) of each vehicle, excluding the depot. */
+   std::vector <std::vector <std::pair<int, int>>> m_routes;
+   std::set <int> m_affected;
+
+   void markVehiclesVisiting(int node);
+   void insertVisit(int node, int skill, const std::set <int> &excluded);
+   void setRoutes(bool affectedOnly);
+};
@@ -0,0 +1,230 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "ResultsLog.h"
+
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+using namespace std;
+
+
+namespace {
+
+/**
+ * Appends `row` to file `fname` holding an advisory lock on it. `header` is
+ * written first when the file is empty. A file starting with another header
+ * (i.e., written with another schema) is renamed aside, and a new file is
+ * started.
+ */
+void appendLocked(const string &fname, const char *header, const string &row) {
+   for (;;) {
+      FILE *fid = fopen(fname.c_str(), "a+");
+      if (!fid) {
+         cout << "File " << fname << " could not be opened." << endl;
+         return;
+      }
+      flock(fileno(fid), LOCK_EX);
+
+      // Another process may have renamed the file while we waited for the lock.
+      struct stat opened, current;
+      if (fstat(fileno(fid), &opened) != 0 || stat(fname.c_str(), &current) != 0 ||
+            opened.st_dev != current.st_dev || opened.st_ino != current.st_ino) {
+         flock(fileno(fid), LOCK_UN);
+         fclose(fid);
+         continue;
+      }
+
+      fseek(fid, 0, SEEK_END);
+      if (header && ftell(fid) > 0) {
+         rewind(fid);
+         string firstLine;
+         int c;
+         while ((c = fgetc(fid)) != EOF) {
+            firstLine += char(c);
+            if (c == '\n')
+               break;
+         }
+
+         if (firstLine != header) {
+            ostringstream aside;
+            aside << fname << "." << long(time(nullptr)) << "-" << long(getpid());
+            const bool moved = rename(fname.c_str(), aside.str().c_str()) == 0;
+            flock(fileno(fid), LOCK_UN);
+            fclose(fid);
+            if (!moved) {
+               cout << "File " << fname << " has another header and could not be renamed." << endl;
+               return;
+            }
+            cout << "File " << fname << " has another header; moved to " << aside.str() << "." << endl;
+            continue;
+         }
+      }
+
+      // Write the header if the file is created in this run.
+      fseek(fid, 0, SEEK_END);
+      if (header && ftell(fid) == 0)
+         fputs(header, fid);
+
+      fputs(row.c_str(), fid);
+      fflush(fid);
+      flock(fileno(fid), LOCK_UN);
+      fclose(fid);
+      return;
+   }
+}
+
+}
+
+ResultsLog::ResultsLog(const std::string &fname): m_fname(fname) {
+   // Empty
+}
+
+ResultsLog::~ResultsLog() {
+   // Empty
+}
+
+void ResultsLog::append(const RunResult &res) {
+   ostringstream row;
+   row <<
+      res.instance << "," <<
+      res.seed << "," <<
+      res.timeBest << "," <<
+      res.timeTotal << "," <<
+      res.cost << "," <<
+      res.memInstance << "," <<
+      res.memModel << "," <<
+      res.modelVars << "," <<
+      res.modelRows << "," <<
+      res.modelNnz << "," <<
+      res.rssLoad << "," <<
+      res.rssBuild << "," <<
+      res.rssInitial << "," <<
+      res.rssSearch << ",";
+   if (res.hasBound)
+      row << res.lowerBound << "," << res.gap;
+   else
+      row << ",";
+   row << "\n";
+
+   lock_guard <mutex> guard(m_mutex);
+   appendLocked(m_fname,
+      "instance,"
+      "seed,"
+      "time.best,"
+      "time.total,"
+      "cost,"
+      "mem.instance,"
+      "mem.model,"
+      "model.vars,"
+      "model.rows,"
+      "model.nnz,"
+      "rss.load,"
+      "rss.build,"
+      "rss.initial,"
+      "rss.search,"
+      "lb,"
+      "gap\n", row.str());
+}
+
+TrajectoryLog::TrajectoryLog(const std::string &fname): m_fname(fname) {
+   // Empty
+}
+
+TrajectoryLog::~TrajectoryLog() {
+   // Empty
+}
+
+void TrajectoryLog::append(const RunResult &res) {
+   lock_guard <mutex> guard(m_mutex);
+
+   // Unique among the processes sharing the file, even for repeated seeds.
+   ostringstream runId;
+   runId << long(time(nullptr)) << "-" << long(getpid()) << "-" << ++m_numRuns;
+
+   ostringstream rows;
+   rows << setprecision(10);
+   for (const IncumbentPoint &p: res.trajectory) {
+      rows <<
+         res.instance << "," <<
+         res.seed << "," <<
+         p.iter << "," <<
+         p.time << "," <<
+         p.obj << "," <<
+         p.decomp << "," <<
+         runId.str() <<
+      "\n";
+   }
+
+   appendLocked(m_fname,
+      "instance,"
+      "seed,"
+      "iter,"
+      "time,"
+      "obj,"
+      "decomp,"
+      "run\n", rows.str());
+}
+
+TraceLog::TraceLog(const std::string &fname): m_fname(fname) {
+   // Empty
+}
+
+TraceLog::~TraceLog() {
+   // Empty
+}
+
+void TraceLog::append(const std::string &line) {
+   lock_guard <mutex> guard(m_mutex);
+   appendLocked(m_fname, nullptr, line + "\n");
+}
+
+std::string jsonEscape(const std::string &text) {
+   ostringstream out;
+   for (const char c: text) {
+      if (c == '"' || c == '\\')
+         out << '\\' << c;
+      else if (c == '\n')
+         out << "\\n";
+      else if (c == '\t')
+         out << "\\t";
+      else if (static_cast<unsigned char>(c) < 0x20)
+         out << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec << setfill(' ');
+      else
+         out << c;
+   }
+   return out.str();
+}
@@ -0,0 +1,145 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Point of the incumbent trajectory of a run: elapsed time (in seconds),
+ * objective value, iteration and decomposition that found it.
+ */
+struct IncumbentPoint {
+   double time;
+   double obj;
+   int iter;
+   std::string decomp;
+};
+
+/**
+ * Summary of a fix-and-optimize run, as registered in the results file.
+ */
+struct RunResult {
+   std::string instance;
+   long seed;
+   double timeBest;
+   double timeTotal;
+   double cost;
+
+   /**
+    * Memory footprint: instance data and Concert environment (in KB), size of
+    * the extracted MIP model, and peak RSS of the process (in KB) after
+    * each phase of the run: instance load, model build, initial solution
+    * and search.
+    */
+   long memInstance = 0;
+   long memModel = 0;
+   long modelVars = 0;
+   long modelRows = 0;
+   long modelNnz = 0;
+   long rssLoad = 0;
+   long rssBuild = 0;
+   long rssInitial = 0;
+   long rssSearch = 0;
+
+   /**
+    * Global lower bound of the instance and relative gap of the cost to it
+    * (see `LowerBounder`); left empty in the results file when the bound was
+    * not computed.
+    */
+   bool hasBound = false;
+   double lowerBound = 0.0;
+   double gap = 0.0;
+
+   /**
+    * Improving solutions of the run, starting at the initial solution and
+    * ending at a point of type "end" with the final cost and total time.
+    */
+   std::vector <IncumbentPoint> trajectory;
+};
+
+/**
+ * Appends run results to a CSV file.
+ * Writes are serialized among threads sharing the object, and among processes
+ * through an advisory lock on the file.
+ */
+class ResultsLog {
+public:
+   ResultsLog(const std::string &fname);
+   virtual ~ResultsLog();
+
+   void append(const RunResult &res);
+
+private:
+   std::string m_fname;
+   std::mutex m_mutex;
+};
+
+/**
+ * Appends incumbent trajectories of runs to a CSV file, one row per point.
+ * All rows of a run are written at once, so the file may be shared among
+ * concurrent runs, with the same locking scheme of `ResultsLog`. Each call of
+ * `append` is a run, told apart from the others by the `run` column.
+ */
+class TrajectoryLog {
+public:
+   TrajectoryLog(const std::string &fname);
+   virtual ~TrajectoryLog();
+
+   void append(const RunResult &res);
+
+private:
+   std::string m_fname;
+   std::mutex m_mutex;
+   long m_numRuns = 0;
+};
+
+/**
+ * Appends lines of a structured trace (e.g., JSON lines) to a file.
+ * Each line is written atomically, so a trace may be shared among concurrent
+ * runs, with the same locking scheme of `ResultsLog`.
+ */
+class TraceLog {
+public:
+   TraceLog(const std::string &fname);
+   virtual ~TraceLog();
+
+   void append(const std::string &line);
+
+private:
+   std::string m_fname;
+   std::mutex m_mutex;
+};
+
+/**
+ * Escapes `text` to be written between the quotes of a JSON string (e.g.,
+ * file names in trace lines).
+ */
+std::string jsonEscape(const std::string &text);
@@ -0,0 +1,208 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "Runner.h"
+#include "Checkpoint.h"
+#include "FixAndOptimize.h"
+#include "InitialRouting.h"
+#include "LowerBounder.h"
+#include "MemoryUsage.h"
+#include "MipModel.h"
+#include "SolutionArchive.h"
+#include "SolutionCopy.h"
+#include "SolutionFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+
+using namespace std;
+
+
+RunResult runFixAndOptimize(const Instance &inst, const RunSettings &settings) {
+   const long rssLoad = peakRssKb();
+
+   if (settings.verbose)
+      cout << "Creating MIP model... " << flush;
+   unique_ptr <MipModel> model(new MipModel(inst, settings.modelCache, settings.formulation));
+   if (settings.verbose)
+      cout << (model->fromCache() ? "Done! (loaded from cache)" : "Done!") << endl;
+   const long rssBuild = peakRssKb();
+
+   RunResult res = runFixAndOptimize(*model, settings);
+   res.rssLoad = rssLoad;
+   res.rssBuild = rssBuild;
+   return res;
+}
+
+RunResult runFixAndOptimize(MipModel &model, const RunSettings &settings) {
+   const Instance &inst = model.instance();
+
+   RunResult res;
+   res.memInstance = long(inst.memoryBytes() / 1024);
+
+   const MipModel::ModelStats modelStats = model.modelStats();
+   res.memModel = modelStats.envBytes / 1024;
+   res.modelVars = modelStats.variables;
+   res.modelRows = modelStats.constraints;
+   res.modelNnz = modelStats.nonzeros;
+
+   model.setQuiet(true);
+   model.maxThreads(1);
+   model.detTimeLimit(settings.maxIterTicks);
+
+   // Started first, so the bounding model is built while the initial
+   // solution is created.
+   unique_ptr <LowerBounder> bounder;
+   if (settings.lowerBound) {
+      bounder.reset(new LowerBounder(inst, settings.modelCache, model.formulation()));
+      bounder->start();
+   }
+
+   // Checkpoints of other instances, or whose routes are not a feasible
+   // solution anymore, are ignored.
+   string error;
+   Checkpoint checkpoint;
+   bool resume = false;
+   if (!settings.resumeFile.empty()) {
+      resume = checkpoint.read(settings.resumeFile, inst, error);
+      if (!resume)
+         cout << "No valid checkpoint in " << settings.resumeFile << " (" << error << "); starting a new run." << endl;
+   }
+
+   unique_ptr <SolutionArchive> archive;
+   if (!settings.archiveDir.empty())
+      archive.reset(new SolutionArchive(settings.archiveDir));
+
+   // The archived solution is used only when no other starting point is
+   // given, and if it is still valid.
+   double archivedCost = 0.0;
+   SolutionArchive::Routes archived;
+   const bool warmStart = archive && settings.archiveWarmStart && !resume && settings.initialSolution.empty() &&
+      archive->best(inst, archivedCost, archived);
+
+   if (warmStart) {
+      if (settings.verbose)
+         cout << "Starting from the archived solution (cost " << archivedCost << ")... " << flush;
+      solutionCopy(archived, model);
+      if (settings.verbose)
+         cout << "Done!" << endl;
+   } else if (resume) {
+      if (settings.verbose)
+         cout << "Resuming from " << settings.resumeFile << " (iteration " << checkpoint.iter << ", elapsed " <<
+            checkpoint.elapsed << " secs)... " << flush;
+      solutionCopy(checkpoint.routes, model);
+      if (settings.verbose)
+         cout << "Done!" << endl;
+   } else {
+      SolutionRoutes initial;
+      if (!settings.initialSolution.empty()) {
+         if (settings.verbose)
+            cout << "Reading initial solution from " << settings.initialSolution << "... " << flush;
+         if (readSolutionFile(settings.initialSolution, inst, initial, error)) {
+            solutionCopy(initial, model);
+            if (settings.verbose)
+               cout << "Done!" << endl;
+         } else {
+            cout << "Invalid initial solution " << settings.initialSolution << ": " << error <<
+               "; using the constructive solution instead." << endl;
+            initial.clear();
+         }
+      }
+
+      if (initial.empty()) {
+         if (settings.verbose)
+            cout << "Creating initial constructive solution... " << flush;
+         unique_ptr<InitialRouting> iniSol(new InitialRouting(inst));
+         iniSol->solve();
+         solutionCopy(*iniSol, model);
+         if (settings.verbose)
+            cout << "Done!" << endl;
+      }
+   }
+
+   if (settings.verbose)
+      cout << "Setting solution to MIP model..." << endl;
+   if (!model.trySolve())
+      throw runtime_error("The initial solution is infeasible for the MIP model.");
+   if (settings.verbose)
+      cout << "Done! Initial solution cost: " << model.objValue() << "." << endl;
+   res.rssInitial = peakRssKb();
+
+   const int maxIterNoImpr = settings.maxIterNoImpr >= 0 ? settings.maxIterNoImpr : (inst.numNodes()-2)/2;
+
+   unique_ptr <FixAndOptimize> feoSolver(new FixAndOptimize(model));
+   feoSolver->setVerbose(settings.verbose);
+   feoSolver->setTrace(settings.trace);
+   feoSolver->setProgress(settings.progress);
+   feoSolver->setTimeBudget(settings.maxSeconds);
+   feoSolver->setSymmetryBreaking(settings.symmetryBreaking);
+   feoSolver->setDecompositions(settings.decompositions);
+   feoSolver->setReducedCostFixing(settings.reducedCostFixing);
+   feoSolver->setBoundPropagation(settings.boundPropagation);
+   feoSolver->setPartnerTiming(settings.partnerTiming);
+   feoSolver->setLowerBounder(bounder.get(), settings.stopGap);
+   feoSolver->setCheckpoint(settings.checkpointFile, settings.checkpointInterval);
+   feoSolver->setArchive(archive.get(), settings.archiveInterval);
+   const long seed = resume ? checkpoint.seed : settings.seed;
+   if (resume)
+      feoSolver->setResume(&checkpoint);
+   feoSolver->solve(seed, maxIterNoImpr, settings.maxIterSeconds);
+
+   res.rssSearch = peakRssKb();
+   res.instance = inst.fileName();
+   res.seed = seed;
+   res.timeBest = feoSolver->timeBest();
+   res.timeTotal = feoSolver->timeTotal();
+   res.cost = model.objValue();
+   res.trajectory = feoSolver->trajectory();
+
+   if (bounder) {
+      bounder->stop();
+      res.hasBound = bounder->bound() > -numeric_limits<double>::infinity();
+      if (res.hasBound) {
+         res.lowerBound = bounder->bound();
+         res.gap = max(0.0, (res.cost - res.lowerBound) / fabs(res.cost));
+      }
+      if (settings.verbose)
+         cout << "Lower bound: " << (res.hasBound ? to_string(res.lowerBound) : string("none")) <<
+            (bounder->proven() ? " (search finished)" : "") << ", gap: " << res.gap * 100 << "%" << endl;
+   }
+
+   if (!settings.solutionFile.empty() && !writeSolutionFile(settings.solutionFile, inst, model.routes(), res.cost,
+         settings.binarySolution ? SolutionFormat::BINARY : SolutionFormat::TEXT))
+      cout << "Solution file " << settings.solutionFile << " could not be written." << endl;
+
+   if (archive && archive->offer(inst, res.cost, model.routes()) && settings.verbose)
+      cout << "New best solution stored in the archive " << settings.archiveDir << "." << endl;
+   return res;
+}
@@ -0,0 +1,145 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "FixAndOptimize.h"
+#include "Instance.h"
+#include "MipModel.h"
+#include "ResultsLog.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Settings of a single fix-and-optimize run.
+ */
+struct RunSettings {
+   long seed = 0;
+
+   /** Iterations without improvement before stopping; -1 uses (nodes-2)/2. */
+   int maxIterNoImpr = -1;
+
+   /** Time limit of each subproblem, in seconds. */
+   int maxIterSeconds = 25;
+
+   /** Deterministic time limit of each subproblem, in CPLEX ticks; 0 disables it. */
+   double maxIterTicks = 0.0;
+
+   /** Directory of the MIP model cache; empty disables it. */
+   std::string modelCache;
+
+   /** Formulation of the synchronization constraints (see `MipModel::Formulation`). */
+   MipModel::Formulation formulation = MipModel::Formulation::VEHICLE;
+
+   /** File with the initial solution; empty runs the constructive heuristic. */
+   std::string initialSolution;
+
+   /** Wall-clock budget of the search, in seconds; 0 disables it. */
+   double maxSeconds = 0.0;
+
+   /** Called at the end of each iteration of the search; may be empty. */
+   FixAndOptimize::ProgressCallback progress;
+
+   /** Receives the per-iteration trace of the run; may be shared among runs. */
+   TraceLog *trace = nullptr;
+
+   /** File receiving periodic checkpoints of the search; empty disables them. */
+   std::string checkpointFile;
+
+   /** Minimum interval between checkpoints, in seconds. */
+   double checkpointInterval = 60.0;
+
+   /**
+    * Checkpoint to resume the run from. If it does not exist or belongs to
+    * another instance, the run starts from scratch.
+    */
+   std::string resumeFile;
+
+   /** File to write the final solution into (see `SolutionFile.h`); empty disables it. */
+   std::string solutionFile;
+   bool binarySolution = false;
+
+   /**
+    * Directory of the elite solution archive; empty disables it. Improving
+    * incumbents of the run are offered to it during the search, at most once
+    * every `archiveInterval` seconds, and the final solution at the end; they
+    * are stored when they beat the archived one.
+    */
+   std::string archiveDir;
+   double archiveInterval = 60.0;
+
+   /**
+    * Starts from the archived solution of the instance, if there is one (and
+    * no checkpoint nor initial solution file is given).
+    */
+   bool archiveWarmStart = true;
+
+   /** Orders interchangeable vehicles freed together (see `FixAndOptimize::setSymmetryBreaking`). */
+   bool symmetryBreaking = false;
+
+   /** Decompositions drawn by the search; empty keeps the default ones. */
+   std::vector <FixAndOptimize::DecompMethod> decompositions;
+
+   /** Removes arcs by their LP reduced costs (see `FixAndOptimize::setReducedCostFixing`). */
+   bool reducedCostFixing = false;
+
+   /** Bounds tardiness and start times by the incumbent (see `FixAndOptimize::setBoundPropagation`). */
+   bool boundPropagation = false;
+
+   /** Reschedules, without rerouting, the partners of the freed vehicles only (see `FixAndOptimize::setPartnerTiming`). */
+   bool partnerTiming = false;
+
+   /**
+    * Computes a global lower bound alongside the search (see `LowerBounder`),
+    * reported in the results, and stops the search once the relative gap to
+    * it is at most `stopGap`.
+    */
+   bool lowerBound = false;
+   double stopGap = 1e-4;
+
+   /** Prints the progress of the run. */
+   bool verbose = false;
+};
+
+/**
+ * Builds the MIP model of `inst`, creates the initial solution and runs the
+ * fix-and-optimize matheuristic on it.
+ * Every call creates its own MIP model (hence its own CPLEX environment), so
+ * concurrent calls on the same instance are safe.
+ * Throws `std::runtime_error` if the model has no feasible solution.
+ */
+RunResult runFixAndOptimize(const Instance &inst, const RunSettings &settings);
+
+/**
+ * Same as above, but on an existing MIP model, e.g. one kept from a previous
+ * run. All variables of the model must be unfixed (see
+ * `MipModel::unfixSolution`). The memory fields related to the model
+ * construction are left empty.
+ */
+RunResult runFixAndOptimize(MipModel &model, const RunSettings &settings);
@@ -0,0 +1,92 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "SolutionArchive.h"
+
+#include <cstdio>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+using namespace std;
+
+SolutionArchive::SolutionArchive(const std::string &dir): m_dir(dir) {
+   // Empty
+}
+
+SolutionArchive::~SolutionArchive() {
+   // Empty
+}
+
+bool SolutionArchive::best(const Instance &inst, double &cost, Routes &routes) const {
+   string error;
+   return readSolutionFile(recordPath(inst.contentHash()), inst, routes, cost, error);
+}
+
+bool SolutionArchive::offer(const Instance &inst, double cost, const Routes &routes) {
+   const string path = recordPath(inst.contentHash());
+   const string lockPath = path + ".lock";
+
+   // The directory is created on the first update.
+   mkdir(m_dir.c_str(), 0755);
+
+   int lockFd = open(lockPath.c_str(), O_CREAT | O_RDWR, 0644);
+   if (lockFd < 0) {
+      cout << "Archive lock " << lockPath << " could not be opened." << endl;
+      return false;
+   }
+   flock(lockFd, LOCK_EX);
+
+   // A record that can not be read (e.g., of an older format) is replaced.
+   double storedCost;
+   Routes storedRoutes;
+   bool stored = false;
+   if (!best(inst, storedCost, storedRoutes) || cost < storedCost - 1e-6) {
+      const string tmp = path + ".tmp" + to_string(getpid());
+      stored = writeSolutionFile(tmp, inst, routes, cost, SolutionFormat::TEXT) &&
+         rename(tmp.c_str(), path.c_str()) == 0;
+      if (!stored) {
+         cout << "Archive record " << path << " could not be written." << endl;
+         remove(tmp.c_str());
+      }
+   }
+
+   flock(lockFd, LOCK_UN);
+   close(lockFd);
+   return stored;
+}
+
+std::string SolutionArchive::recordPath(uint64_t hash) const {
+   char name[64];
+   snprintf(name, sizeof name, "/elite-%016llx.txt", (unsigned long long) hash);
+   return m_dir + name;
+}
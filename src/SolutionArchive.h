@@ -0,0 +1,68 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "SolutionFile.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Archive of the best known solution of each instance, keyed by the content
+ * hash of the instance (see `Instance::contentHash`). Each instance has one
+ * small solution file (see `SolutionFile.h`, text format) in the archive
+ * directory, with the cost and the routes of its best solution.
+ * Updates are serialized among threads and processes through an advisory
+ * lock, and files are replaced atomically.
+ */
+class SolutionArchive {
+public:
+   /** Visits (node, skill) of each vehicle, excluding the depot. */
+   using Routes = SolutionRoutes;
+
+   SolutionArchive(const std::string &dir);
+   virtual ~SolutionArchive();
+
+   /**
+    * Reads the best solution stored for the instance. Returns false if there
+    * is none, or if it is not a valid solution of the instance.
+    */
+   bool best(const Instance &inst, double &cost, Routes &routes) const;
+
+   /**
+    * Stores the solution if it is better than the one in the archive.
+    * Returns true if it was stored.
+    */
+   bool offer(const Instance &inst, double cost, const Routes &routes);
+
+private:
+   std::string m_dir;
+
+   std::string recordPath(uint64_t hash) const;
+};
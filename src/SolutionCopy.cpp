@@ -27,10 +27,6 @@
 
 #include "SolutionCopy.h"
 
-#include <iostream>
-#include <fstream>
-#include <string>
-
 
 using namespace std;
 
@@ -61,24 +57,6 @@ void solutionCopy(const InitialRouting& origin, MipModel& dest) {
    }
 }
 
-void solutionCopy(ifstream &file, MipModel& dest) {
-   if (!file) abort();
-
-   // Ignore header lines.
-   string line;
-   getline(file, line);
-   getline(file, line);
-   getline(file, line);
-   getline(file, line);
-
-   // Read the structured solution file.
-   int v, len;
-   while (file >> v >> len) {
-      for (int row = 0; row < len; ++row) {
-         int i, j, s;
-         file >> i >> j >> v >> s;
-         dest.setVarX(i, j, v, s, 1.0, 1.0);
-      }
-   }
+void solutionCopy(const vector <vector <pair<int, int>>> &routes, MipModel &dest) {
+   dest.setRoutes(routes);
 }
-
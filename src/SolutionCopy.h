@@ -30,7 +30,8 @@
 #include "MipModel.h"
 #include "InitialRouting.h"
 
-#include <iosfwd>
+#include <utility>
+#include <vector>
 
 /**
  * Copies a solution from the constructive heuristic to the MIP model.
@@ -39,7 +40,7 @@ void solutionCopy(const InitialRouting &origin, MipModel &dest);
 
 
 /**
- * Copy a solution from a file to the MIP model.
+ * Copy a solution given as the visits (node, skill) of each vehicle (see
+ * `MipModel::routes`) to the MIP model.
  */
-void solutionCopy(std::ifstream &file, MipModel &dest);
-
+void solutionCopy(const std::vector <std::vector <std::pair<int, int>>> &routes, MipModel &dest);
@@ -0,0 +1,369 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "SolutionFile.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+
+using namespace std;
+
+namespace {
+
+const char *textMagic = "HHCRSP-ROUTES";
+const int textVersion = 1;
+const char binaryMagic[8] = {'H', 'H', 'C', 'R', 'S', 'P', 'B', '1'};
+
+/**
+ * Longest route a valid solution may have: every service of the instance.
+ */
+size_t maxRouteLength(const Instance &inst) {
+   return size_t(inst.numNodes()) * inst.numSkills();
+}
+
+bool fail(string &error, const string &message) {
+   error = message;
+   return false;
+}
+
+bool readText(istream &in, const Instance &inst, SolutionRoutes &routes, double &cost, string &error) {
+   string key;
+   int version = 0;
+   uint64_t hash = 0;
+   size_t numRoutes = 0;
+
+   if (!(in >> version) || version != textVersion)
+      return fail(error, "unsupported version");
+   if (!(in >> key >> hex >> hash >> dec) || key != "instance")
+      return fail(error, "malformed instance hash");
+   if (hash != inst.contentHash())
+      return fail(error, "solution written for another instance");
+   if (!(in >> key >> cost) || key != "cost")
+      return fail(error, "malformed cost");
+   if (!(in >> key >> numRoutes) || key != "vehicles" || numRoutes != size_t(inst.numVehicles()))
+      return fail(error, "number of vehicles differs from the instance");
+
+   routes.assign(numRoutes, {});
+   for (size_t v = 0; v < numRoutes; ++v) {
+      size_t len = 0;
+      if (!(in >> len) || len > maxRouteLength(inst))
+         return fail(error, "malformed route of vehicle " + to_string(v));
+      routes[v].resize(len);
+      for (auto &visit: routes[v])
+         if (!(in >> visit.first >> visit.second))
+            return fail(error, "truncated route of vehicle " + to_string(v));
+   }
+   return true;
+}
+
+template <typename T>
+bool readValue(istream &in, T &value) {
+   return bool(in.read(reinterpret_cast<char*>(&value), sizeof value));
+}
+
+bool readBinary(istream &in, const Instance &inst, SolutionRoutes &routes, double &cost, string &error) {
+   uint64_t hash = 0;
+   int32_t numRoutes = 0;
+
+   if (!readValue(in, hash) || !readValue(in, cost) || !readValue(in, numRoutes))
+      return fail(error, "truncated header");
+   if (hash != inst.contentHash())
+      return fail(error, "solution written for another instance");
+   if (numRoutes != inst.numVehicles())
+      return fail(error, "number of vehicles differs from the instance");
+
+   vector <int32_t> buf;
+   routes.assign(numRoutes, {});
+   for (int v = 0; v < numRoutes; ++v) {
+      int32_t len = 0;
+      if (!readValue(in, len) || len < 0 || size_t(len) > maxRouteLength(inst))
+         return fail(error, "malformed route of vehicle " + to_string(v));
+      buf.resize(2 * size_t(len));
+      if (!in.read(reinterpret_cast<char*>(buf.data()), buf.size() * sizeof(int32_t)))
+         return fail(error, "truncated route of vehicle " + to_string(v));
+      routes[v].resize(len);
+      for (int k = 0; k < len; ++k)
+         routes[v][k] = make_pair(int(buf[2*k]), int(buf[2*k+1]));
+   }
+   return true;
+}
+
+/**
+ * Reads the arcs of the older structured format and chains them into routes,
+ * starting at the depot.
+ */
+bool readArcs(istream &in, const Instance &inst, SolutionRoutes &routes, string &error) {
+   // Ignore header lines.
+   string line;
+   for (int k = 0; k < 4; ++k)
+      if (!getline(in, line))
+         return fail(error, "truncated header");
+
+   // Arcs (j, s) leaving each node, per vehicle.
+   const int nv = inst.numVehicles();
+   vector <vector <vector <pair<int, int>>>> out(nv, vector <vector <pair<int, int>>>(inst.numNodes()));
+   size_t numArcs = 0;
+
+   int v, len;
+   while (in >> v >> len) {
+      for (int row = 0; row < len; ++row) {
+         int i, j, s;
+         if (!(in >> i >> j >> v >> s))
+            return fail(error, "truncated arc list");
+         if (v < 0 || v >= nv || i < 0 || i >= inst.numNodes()-1 || j < 0 || j >= inst.numNodes()-1)
+            return fail(error, "arc out of range");
+         out[v][i].push_back(make_pair(j, s));
+         ++numArcs;
+      }
+   }
+
+   routes.assign(nv, {});
+   size_t chained = 0;
+   for (v = 0; v < nv; ++v) {
+      int curr = 0;
+      while (!out[v][curr].empty()) {
+         const pair<int, int> arc = out[v][curr].back();
+         out[v][curr].pop_back();
+         ++chained;
+         if (arc.first == 0)
+            break;
+         routes[v].push_back(arc);
+         curr = arc.first;
+      }
+   }
+
+   if (chained != numArcs)
+      return fail(error, "arcs do not form one route per vehicle");
+   return true;
+}
+
+}
+
+bool writeSolutionFile(const std::string &path, const Instance &inst, const SolutionRoutes &routes, double cost,
+   SolutionFormat format) {
+   ofstream fid(path, ios::binary);
+   return fid && writeSolution(fid, inst, routes, cost, format);
+}
+
+bool writeSolution(std::ostream &fid, const Instance &inst, const SolutionRoutes &routes, double cost,
+   SolutionFormat format) {
+   if (format == SolutionFormat::BINARY) {
+      const uint64_t hash = inst.contentHash();
+      const int32_t numRoutes = int32_t(routes.size());
+      fid.write(binaryMagic, sizeof binaryMagic);
+      fid.write(reinterpret_cast<const char*>(&hash), sizeof hash);
+      fid.write(reinterpret_cast<const char*>(&cost), sizeof cost);
+      fid.write(reinterpret_cast<const char*>(&numRoutes), sizeof numRoutes);
+
+      vector <int32_t> buf;
+      for (const auto &route: routes) {
+         buf.assign(1, int32_t(route.size()));
+         for (const auto &visit: route) {
+            buf.push_back(visit.first);
+            buf.push_back(visit.second);
+         }
+         fid.write(reinterpret_cast<const char*>(buf.data()), buf.size() * sizeof(int32_t));
+      }
+   } else {
+      fid << textMagic << " " << textVersion << "\n";
+      fid << "instance " << hex << inst.contentHash() << dec << "\n";
+      fid << "cost " << setprecision(17) << cost << "\n";
+      fid << "vehicles " << routes.size() << "\n";
+      for (const auto &route: routes) {
+         fid << route.size();
+         for (const auto &visit: route)
+            fid << " " << visit.first << " " << visit.second;
+         fid << "\n";
+      }
+   }
+
+   return bool(fid);
+}
+
+bool readSolutionFile(const std::string &path, const Instance &inst, SolutionRoutes &routes, std::string &error) {
+   double cost;
+   return readSolutionFile(path, inst, routes, cost, error);
+}
+
+bool readSolutionFile(const std::string &path, const Instance &inst, SolutionRoutes &routes, double &cost,
+   std::string &error) {
+   ifstream fid(path, ios::binary);
+   if (!fid)
+      return fail(error, "file can not be read");
+   return readSolution(fid, inst, routes, cost, error);
+}
+
+bool readSolution(std::istream &in, const Instance &inst, SolutionRoutes &routes, std::string &error) {
+   double cost;
+   return readSolution(in, inst, routes, cost, error);
+}
+
+bool readSolution(std::istream &in, const Instance &inst, SolutionRoutes &routes, double &cost, std::string &error) {
+   const streampos start = in.tellg();
+   char magic[sizeof binaryMagic] = {};
+   in.read(magic, sizeof magic);
+
+   bool ok;
+   if (in && memcmp(magic, binaryMagic, sizeof magic) == 0) {
+      ok = readBinary(in, inst, routes, cost, error);
+   } else if (in && memcmp(magic, textMagic, sizeof magic) == 0) {
+      string rest;
+      ok = in >> rest && string(magic, sizeof magic) + rest == textMagic;
+      ok = ok ? readText(in, inst, routes, cost, error) : fail(error, "unknown format");
+   } else {
+      in.clear();
+      in.seekg(start);
+      cost = numeric_limits<double>::infinity();
+      ok = readArcs(in, inst, routes, error);
+   }
+
+   return ok && validateRoutes(inst, routes, error);
+}
+
+bool validateRoutes(const Instance &inst, const SolutionRoutes &routes, std::string &error) {
+   const int n = inst.numNodes(), nv = inst.numVehicles(), ns = inst.numSkills();
+   if (int(routes.size()) != nv)
+      return fail(error, "number of routes differs from the number of vehicles");
+
+   // Service assignment and flow: visits of customers, by vehicles that have
+   // the skills required, each service provided exactly once, and no arc
+   // from a node to itself.
+   vector <int> visitOf(size_t(n) * ns, -1);
+   vector <pair<int, int>> visits;
+   for (int v = 0; v < nv; ++v) {
+      int prev = 0;
+      for (const auto &visit: routes[v]) {
+         const int i = visit.first, s = visit.second;
+         ostringstream where;
+         where << "visit " << i << "/" << s << " of vehicle " << v;
+         if (i < 1 || i >= n-1 || s < 0 || s >= ns)
+            return fail(error, where.str() + " is out of range");
+         if (!inst.nodeReqSkill(i, s))
+            return fail(error, where.str() + " provides a service not required");
+         if (!inst.vehicleHasSkill(v, s))
+            return fail(error, where.str() + " needs a skill the vehicle does not have");
+         if (i == prev)
+            return fail(error, where.str() + " repeats the previous node");
+         if (visitOf[i * ns + s] != -1)
+            return fail(error, where.str() + " provides a service already provided");
+         visitOf[i * ns + s] = int(visits.size());
+         visits.push_back(make_pair(v, i));
+         prev = i;
+      }
+   }
+   for (int i = 1; i < n-1; ++i)
+      for (int s = 0; s < ns; ++s)
+         if (inst.nodeReqSkill(i, s) && visitOf[i * ns + s] == -1)
+            return fail(error, "service " + to_string(i) + "/" + to_string(s) + " is not provided");
+
+   // Earliest start times, as the longest paths of the difference constraints
+   // of the model: precedence along the routes (which also involve the start
+   // times of the other services a vehicle could provide at a node), start of
+   // the time windows, and synchronization. The times only grow, so they
+   // settle in at most one pass per visit unless the synchronizations form a
+   // cycle that can not be met.
+   const double eps = 1e-6;
+   vector <double> start(visits.size());
+   vector <double> release(visits.size());
+   for (int v = 0; v < nv; ++v) {
+      int prev = 0;
+      int prevSkill = -1;
+      for (const auto &visit: routes[v]) {
+         const int i = visit.first, k = visitOf[i * ns + visit.second];
+         release[k] = inst.nodeTwMin(i);
+         for (int s = 0; s < ns; ++s)
+            if (s != prevSkill && inst.nodeReqSkill(prev, s) && inst.vehicleHasSkill(v, s))
+               release[k] = max(release[k], inst.nodeTwMin(prev) + inst.nodeProcTime(prev, s) + inst.distance(prev, i));
+         prev = i;
+         prevSkill = visit.second;
+      }
+   }
+   start = release;
+
+   struct Sync {
+      int k1, k2;
+      double deltaMin, deltaMax;
+   };
+   vector <Sync> syncs;
+   for (int i = 1; i < n-1; ++i) {
+      if (inst.nodeSvcType(i) != Instance::SIM && inst.nodeSvcType(i) != Instance::PRED)
+         continue;
+      int k1 = -1, k2 = -1;
+      for (int s = 0; s < ns; ++s) {
+         if (visitOf[i * ns + s] == -1)
+            continue;
+         (k1 == -1 ? k1 : k2) = visitOf[i * ns + s];
+      }
+      if (k2 == -1)
+         return fail(error, "synchronized node " + to_string(i) + " does not require two services");
+      if (visits[k1].first == visits[k2].first)
+         return fail(error, "services of synchronized node " + to_string(i) + " are provided by the same vehicle");
+      syncs.push_back(Sync{k1, k2, inst.nodeDeltaMin(i), inst.nodeDeltaMax(i)});
+   }
+
+   auto relax = [&] (int k, double t) {
+      if (t <= start[k] + eps)
+         return false;
+      start[k] = t;
+      return true;
+   };
+
+   for (size_t pass = 0;; ++pass) {
+      bool changed = false;
+      for (int v = 0; v < nv; ++v) {
+         const auto &route = routes[v];
+         for (size_t pos = 1; pos < route.size(); ++pos) {
+            const int h = route[pos-1].first, i = route[pos].first;
+            const int kh = visitOf[h * ns + route[pos-1].second], ki = visitOf[i * ns + route[pos].second];
+            changed |= relax(ki, start[kh] + inst.nodeProcTime(h, route[pos-1].second) + inst.distance(h, i));
+         }
+      }
+
+      int violated = -1;
+      for (const Sync &sync: syncs) {
+         bool moved = relax(sync.k2, start[sync.k1] + sync.deltaMin);
+         moved |= relax(sync.k1, start[sync.k2] - sync.deltaMax);
+         if (moved)
+            violated = visits[sync.k1].second;
+         changed |= moved;
+      }
+
+      if (!changed)
+         break;
+      if (pass > visits.size())
+         return fail(error, "synchronization of node " + to_string(violated) + " can not be met");
+   }
+
+   return true;
+}
@@ -0,0 +1,93 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "Instance.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Solution files store the visits (node, skill) of each vehicle, excluding
+ * the depot (see `MipModel::routes`), the content hash of the instance they
+ * were written for and their cost. They come in a text and a binary variant:
+ *
+ *   HHCRSP-ROUTES 1                   "HHCRSPB1"
+ *   instance <hash, hexadecimal>      uint64 instance hash
+ *   cost <cost>                       double cost
+ *   vehicles <V>                      int32 V
+ *   <len> <node> <skill> ...          int32 len, len x (int32 node, int32 skill)
+ *   (one line per vehicle)            (for each vehicle)
+ *
+ * The reader also accepts the older structured files listing the arcs
+ * `x(i,j,v,s)` of the solution (four header lines, then `<v> <len>` followed
+ * by `len` rows `<i> <j> <v> <s>`).
+ */
+using SolutionRoutes = std::vector <std::vector <std::pair<int, int>>>;
+
+enum class SolutionFormat {
+   TEXT,
+   BINARY
+};
+
+/**
+ * Writes the routes into `path` (or at the current position of `out`, e.g.
+ * as a section of another file). Returns false if they can not be written.
+ */
+bool writeSolutionFile(const std::string &path, const Instance &inst, const SolutionRoutes &routes, double cost,
+   SolutionFormat format);
+bool writeSolution(std::ostream &out, const Instance &inst, const SolutionRoutes &routes, double cost,
+   SolutionFormat format);
+
+/**
+ * Reads and validates (see `validateRoutes`) the routes of a solution file of
+ * any format, from `path` or from the current position of `in`. Returns
+ * false, with the reason in `error`, if the file can not be read, was written
+ * for another instance or is not a feasible solution. `cost` receives the
+ * cost stored in the file, or infinity for the older structured format,
+ * which has none.
+ */
+bool readSolutionFile(const std::string &path, const Instance &inst, SolutionRoutes &routes, std::string &error);
+bool readSolutionFile(const std::string &path, const Instance &inst, SolutionRoutes &routes, double &cost,
+   std::string &error);
+bool readSolution(std::istream &in, const Instance &inst, SolutionRoutes &routes, std::string &error);
+bool readSolution(std::istream &in, const Instance &inst, SolutionRoutes &routes, double &cost, std::string &error);
+
+/**
+ * Checks whether the routes are a feasible solution of the instance: each
+ * vehicle has the skills it provides, each service required is provided
+ * exactly once, and there are service start times that respect the routes,
+ * the start of the time windows and the synchronization of the services
+ * (ends of time windows are soft). Returns false with the first violation
+ * found in `error`.
+ */
+bool validateRoutes(const Instance &inst, const SolutionRoutes &routes, std::string &error);
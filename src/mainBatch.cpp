@@ -0,0 +1,169 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "InstancePool.h"
+#include "ResultsLog.h"
+#include "Runner.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+using namespace std;
+
+int main(int argc, char **argv) {
+   if (argc != 5) {
+      std::cout << "Usage: " << argv[0] << " <1: instance list file> <2: first seed> <3: last seed> <4: workers>" << std::endl;
+      return EXIT_FAILURE;
+   }
+
+   const long firstSeed = std::stol(argv[2]);
+   const long lastSeed = std::stol(argv[3]);
+   const int workers = std::max(1, std::stoi(argv[4]));
+
+   vector <string> instances;
+   {
+      ifstream fid(argv[1]);
+      if (!fid) {
+         cout << "Instance list " << argv[1] << " could not be read." << endl;
+         return EXIT_FAILURE;
+      }
+      string line;
+      while (getline(fid, line)) {
+         line.erase(line.find_last_not_of(" \t\r") + 1);
+         if (!line.empty() && line[0] != '#')
+            instances.push_back(line);
+      }
+   }
+
+   Instance::DistanceMode distMode = Instance::DistanceMode::FULL;
+   if (getenv("DISTANCES") && !Instance::parseDistanceMode(getenv("DISTANCES"), distMode)) {
+      cout << "Unknown distance mode: " << getenv("DISTANCES") << endl;
+      return EXIT_FAILURE;
+   }
+   MipModel::Formulation formulation = MipModel::Formulation::VEHICLE;
+   if (getenv("FORMULATION") && !MipModel::parseFormulation(getenv("FORMULATION"), formulation)) {
+      cout << "Unknown formulation: " << getenv("FORMULATION") << endl;
+      return EXIT_FAILURE;
+   }
+   vector <FixAndOptimize::DecompMethod> decompositions;
+   if (getenv("DECOMPOSITIONS") && !FixAndOptimize::parseDecompositions(getenv("DECOMPOSITIONS"), decompositions)) {
+      cout << "Unknown decompositions: " << getenv("DECOMPOSITIONS") << endl;
+      return EXIT_FAILURE;
+   }
+   const bool useCache = !getenv("INSTANCE_CACHE") || string(getenv("INSTANCE_CACHE")) != "0";
+
+   RunSettings baseSettings;
+   baseSettings.modelCache = getenv("MODEL_CACHE") ? getenv("MODEL_CACHE") : "";
+   baseSettings.formulation = formulation;
+   baseSettings.decompositions = decompositions;
+   baseSettings.initialSolution = getenv("INITIAL") ? getenv("INITIAL") : "";
+   baseSettings.archiveDir = getenv("ARCHIVE") ? getenv("ARCHIVE") : "";
+   baseSettings.archiveWarmStart = !getenv("ARCHIVE_WARM_START") || string(getenv("ARCHIVE_WARM_START")) != "0";
+   if (getenv("ARCHIVE_INTERVAL"))
+      baseSettings.archiveInterval = atof(getenv("ARCHIVE_INTERVAL"));
+   baseSettings.symmetryBreaking = getenv("SYMMETRY_BREAKING") && string(getenv("SYMMETRY_BREAKING")) == "1";
+   baseSettings.reducedCostFixing = getenv("REDUCED_COST_FIXING") && string(getenv("REDUCED_COST_FIXING")) == "1";
+   baseSettings.boundPropagation = getenv("BOUND_PROPAGATION") && string(getenv("BOUND_PROPAGATION")) == "1";
+   baseSettings.partnerTiming = getenv("PARTNER_TIMING") && string(getenv("PARTNER_TIMING")) == "1";
+   baseSettings.lowerBound = getenv("LOWER_BOUND") && string(getenv("LOWER_BOUND")) == "1";
+   if (getenv("STOP_GAP"))
+      baseSettings.stopGap = atof(getenv("STOP_GAP"));
+
+   unique_ptr <TraceLog> trace;
+   if (getenv("TRACE")) {
+      trace.reset(new TraceLog(getenv("TRACE")));
+      baseSettings.trace = trace.get();
+   }
+
+   // Seeds of the same instance are kept together, so that workers tend to
+   // share instances (and model caches) that are already loaded.
+   vector <pair<string, long>> jobs;
+   for (const string &inst: instances)
+      for (long seed = firstSeed; seed <= lastSeed; ++seed)
+         jobs.push_back(make_pair(inst, seed));
+
+   cout << "=== Fix-and-Optimize batch runner for HHCRSP ===\n";
+   cout << "Instances: " << instances.size() << "  Seeds: " << firstSeed << ".." << lastSeed <<
+      "  Jobs: " << jobs.size() << "  Workers: " << workers << endl;
+
+   InstancePool pool(distMode, useCache);
+   ResultsLog log("results-fixAndOptimize.csv");
+   unique_ptr <TrajectoryLog> trajLog;
+   if (getenv("TRAJECTORY"))
+      trajLog.reset(new TrajectoryLog(getenv("TRAJECTORY")));
+
+   atomic <size_t> nextJob(0);
+   atomic <size_t> doneJobs(0);
+   mutex outMutex;
+
+   auto worker = [&] () {
+      for (;;) {
+         const size_t k = nextJob++;
+         if (k >= jobs.size())
+            break;
+
+         RunSettings settings = baseSettings;
+         settings.seed = jobs[k].second;
+
+         try {
+            const Instance &inst = pool.get(jobs[k].first);
+            RunResult res = runFixAndOptimize(inst, settings);
+            log.append(res);
+            if (trajLog)
+               trajLog->append(res);
+
+            lock_guard <mutex> guard(outMutex);
+            cout << "[" << ++doneJobs << "/" << jobs.size() << "] " << res.instance <<
+               "  seed: " << res.seed << "  cost: " << res.cost <<
+               "  time: " << res.timeTotal << " secs" << endl;
+         } catch (std::exception &e) {
+            lock_guard <mutex> guard(outMutex);
+            cout << "[" << ++doneJobs << "/" << jobs.size() << "] " << jobs[k].first <<
+               "  seed: " << settings.seed << "  failed: " << e.what() << endl;
+         }
+      }
+   };
+
+   vector <thread> threads;
+   for (int w = 0; w < workers; ++w)
+      threads.emplace_back(worker);
+   for (auto &th: threads)
+      th.join();
+
+   return EXIT_SUCCESS;
+}
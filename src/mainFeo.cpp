@@ -25,15 +25,14 @@
  *
  */
 
-#include "FixAndOptimize.h"
-#include "InitialRouting.h"
 #include "Instance.h"
-#include "MipModel.h"
-#include "SolutionCopy.h"
+#include "ResultsLog.h"
+#include "Runner.h"
 
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 
 
 using namespace std;
@@ -51,38 +50,89 @@ int main(int argc, char **argv) {
    cout << "Instance: " << instPath << endl;
    cout << "PRGN seed: " << seed << endl;
 
-   unique_ptr<Instance> inst(new Instance(instPath));
-
-   cout << "Creating MIP model... " << flush;
-   unique_ptr <MipModel> model(new MipModel(*inst));
-   cout << "Done!" << endl;
-
-   model->setQuiet(true);
-   model->maxThreads(1);
-
-   if (!getenv("INITIAL")) {
-      cout << "Creating initial constructive solution... " << flush;
-      unique_ptr<InitialRouting> iniSol(new InitialRouting(*inst));
-      iniSol->solve();
-      solutionCopy(*iniSol, *model);
-      cout << "Done!" << endl;
-   } else {
-      const char *fname = getenv("INITIAL");
-      cout << "Reading initial solution from " << fname << "... " << flush;
-      ifstream fid(fname);
-      solutionCopy(fid, *model);
-      cout << "Done!" << endl;
+   Instance::DistanceMode distMode = Instance::DistanceMode::FULL;
+   if (getenv("DISTANCES") && !Instance::parseDistanceMode(getenv("DISTANCES"), distMode)) {
+      cout << "Unknown distance mode: " << getenv("DISTANCES") << endl;
+      return EXIT_FAILURE;
+   }
+   MipModel::Formulation formulation = MipModel::Formulation::VEHICLE;
+   if (getenv("FORMULATION") && !MipModel::parseFormulation(getenv("FORMULATION"), formulation)) {
+      cout << "Unknown formulation: " << getenv("FORMULATION") << endl;
+      return EXIT_FAILURE;
+   }
+   vector <FixAndOptimize::DecompMethod> decompositions;
+   if (getenv("DECOMPOSITIONS") && !FixAndOptimize::parseDecompositions(getenv("DECOMPOSITIONS"), decompositions)) {
+      cout << "Unknown decompositions: " << getenv("DECOMPOSITIONS") << endl;
+      return EXIT_FAILURE;
    }
 
-   cout << "Setting solution to MIP model..." << endl;
-   model->solve();
-   cout << "Done! Initial solution cost: " << model->objValue() << "." << endl;
+   const bool useCache = !getenv("INSTANCE_CACHE") || string(getenv("INSTANCE_CACHE")) != "0";
+
+   unique_ptr<Instance> inst;
+   try {
+      inst.reset(new Instance(instPath, distMode, useCache));
+   } catch (const exception &e) {
+      cout << e.what() << endl;
+      return EXIT_FAILURE;
+   }
+   cout << "Distance storage: " << Instance::distanceModeName(inst->distanceMode()) << endl;
+   cout << "Vehicle classes: " << inst->numVehicleClasses() << " (" << inst->numVehicles() << " vehicles)" << endl;
+
+   RunSettings settings;
+   settings.seed = seed;
+   settings.modelCache = getenv("MODEL_CACHE") ? getenv("MODEL_CACHE") : "";
+   settings.formulation = formulation;
+   settings.decompositions = decompositions;
+   settings.initialSolution = getenv("INITIAL") ? getenv("INITIAL") : "";
+   settings.checkpointFile = getenv("CHECKPOINT") ? getenv("CHECKPOINT") : "";
+   if (getenv("CHECKPOINT_INTERVAL"))
+      settings.checkpointInterval = atof(getenv("CHECKPOINT_INTERVAL"));
+   settings.resumeFile = getenv("RESUME") ? getenv("RESUME") : "";
+   settings.archiveDir = getenv("ARCHIVE") ? getenv("ARCHIVE") : "";
+   settings.archiveWarmStart = !getenv("ARCHIVE_WARM_START") || string(getenv("ARCHIVE_WARM_START")) != "0";
+   if (getenv("ARCHIVE_INTERVAL"))
+      settings.archiveInterval = atof(getenv("ARCHIVE_INTERVAL"));
+   settings.symmetryBreaking = getenv("SYMMETRY_BREAKING") && string(getenv("SYMMETRY_BREAKING")) == "1";
+   settings.reducedCostFixing = getenv("REDUCED_COST_FIXING") && string(getenv("REDUCED_COST_FIXING")) == "1";
+   settings.boundPropagation = getenv("BOUND_PROPAGATION") && string(getenv("BOUND_PROPAGATION")) == "1";
+   settings.partnerTiming = getenv("PARTNER_TIMING") && string(getenv("PARTNER_TIMING")) == "1";
+   settings.lowerBound = getenv("LOWER_BOUND") && string(getenv("LOWER_BOUND")) == "1";
+   if (getenv("STOP_GAP"))
+      settings.stopGap = atof(getenv("STOP_GAP"));
+   settings.solutionFile = getenv("SOLUTION") ? getenv("SOLUTION") : "";
+   settings.binarySolution = getenv("SOLUTION_FORMAT") && string(getenv("SOLUTION_FORMAT")) == "binary";
+   settings.verbose = true;
+
+   unique_ptr<TraceLog> trace;
+   if (getenv("TRACE")) {
+      trace.reset(new TraceLog(getenv("TRACE")));
+      settings.trace = trace.get();
+   }
+
+   RunResult res;
+   try {
+      res = runFixAndOptimize(*inst, settings);
+   } catch (const exception &e) {
+      cout << e.what() << endl;
+      return EXIT_FAILURE;
+   }
+
+   // Registers the solution into a CSV file.
+   ResultsLog log("results-fixAndOptimize.csv");
+   log.append(res);
+
+   if (getenv("TRAJECTORY")) {
+      TrajectoryLog trajLog(getenv("TRAJECTORY"));
+      trajLog.append(res);
+   }
 
-   unique_ptr <FixAndOptimize> feoSolver(new FixAndOptimize(*model));
-   feoSolver->solve(seed, (inst->numNodes()-2)/2, 25);
+   cout << "\nMemory: instance " << res.memInstance << " KB, model " << res.memModel << " KB (" <<
+      res.modelVars << " variables, " << res.modelRows << " constraints, " << res.modelNnz << " nonzeros)" << endl;
+   cout << "Peak RSS (KB): load " << res.rssLoad << ", build " << res.rssBuild << ", initial " <<
+      res.rssInitial << ", search " << res.rssSearch << endl;
 
-   cout << "\nBest solution found: " << model->objValue() << endl;
-   cout << "\n" << model->objValue() << endl;
+   cout << "\nBest solution found: " << res.cost << endl;
+   cout << "\n" << res.cost << endl;
 
    return EXIT_SUCCESS;
 }
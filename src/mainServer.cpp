@@ -0,0 +1,360 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019
+ * Alberto Francisco Kummer Neto (afkneto@inf.ufrgs.br),
+ * Luciana Salete Buriol (buriol@inf.ufrgs.br) and
+ * Olinto César Bassi de Araújo (olinto@ctism.ufsm.br)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+/*
+ * Long-lived solver server. Reads requests from stdin, one per line, and
+ * writes responses to stdout, one per line. Instances and their MIP models
+ * are kept resident between requests, so only the first request on an
+ * instance pays for loading and building them. Any other output of the
+ * solver goes to stderr.
+ *
+ * Requests:
+ *   load <instance>
+ *      Loads the instance and builds its model. Answers `loaded <instance>
+ *      <seconds>`.
+ *   solve <id> <instance> [seed=<n>] [budget=<secs>] [iterSeconds=<n>]
+ *         [maxIterNoImpr=<n>] [ticks=<n>] [initial=<solution file>]
+ *      Runs the fix-and-optimize. Streams `progress <id> <iter> <elapsed>
+ *      <obj>` lines, then one `route <id> <vehicle> <node>/<skill> ...` line
+ *      per vehicle, and finishes with `result <id> <cost> <time.best>
+ *      <time.total>`.
+ *   tw <instance> <node> <twMin> <twMax>
+ *   cancel <instance> <node>
+ *   add <instance> <x> <y> <twMin> <twMax> <single|sim|pred> <deltaMin>
+ *       <deltaMax> <skill>:<procTime> [<skill>:<procTime>]
+ *      Change the resident instance and the plan of its last solve. Answer
+ *      `changed <instance> <node>`, where `node` is the index of the node
+ *      changed (or added). Windows must have min <= max, and the skills of
+ *      `add` must be distinct.
+ *   reoptimize <id> <instance> [options of solve, but initial]
+ *      Repairs the plan after the changes and re-optimizes it around the
+ *      affected vehicles. Answers like `solve`.
+ *   unload <instance>
+ *      Releases the instance (and its changes) and its model. Answers
+ *      `unloaded <instance>`.
+ *   quit
+ *      Stops the server.
+ * Failed requests are answered by `error <id or -> <message>`.
+ */
+
+#include "Instance.h"
+#include "MipModel.h"
+#include "Reoptimizer.h"
+#include "Runner.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+
+using namespace std;
+
+namespace {
+
+/**
+ * Instance kept by the server, its model and the plan of its last solve.
+ */
+struct Resident {
+   unique_ptr <Instance> inst;
+   unique_ptr <MipModel> model;
+   unique_ptr <Reoptimizer> reopt;
+};
+
+/**
+ * Reads the `key=value` options of solve requests into `settings`.
+ */
+bool parseOptions(istream &req, RunSettings &settings) {
+   string opt;
+   while (req >> opt) {
+      const size_t eq = opt.find('=');
+      const string key = opt.substr(0, eq);
+      const string value = eq == string::npos ? "" : opt.substr(eq+1);
+      if (key == "seed")
+         settings.seed = atol(value.c_str());
+      else if (key == "budget")
+         settings.maxSeconds = atof(value.c_str());
+      else if (key == "iterSeconds")
+         settings.maxIterSeconds = atoi(value.c_str());
+      else if (key == "maxIterNoImpr")
+         settings.maxIterNoImpr = atoi(value.c_str());
+      else if (key == "ticks")
+         settings.maxIterTicks = atof(value.c_str());
+      else if (key == "initial" && ifstream(value))
+         settings.initialSolution = value;
+      else
+         return false;
+   }
+   return true;
+}
+
+bool parseSvcType(const string &name, Instance::SvcType &type) {
+   if (name == "single")
+      type = Instance::SINGLE;
+   else if (name == "sim")
+      type = Instance::SIM;
+   else if (name == "pred")
+      type = Instance::PRED;
+   else
+      return false;
+   return true;
+}
+
+}
+
+int main(int argc, char **argv) {
+   if (argc != 1) {
+      std::cout << "Usage: " << argv[0] << " (requests are read from stdin)" << std::endl;
+      return EXIT_FAILURE;
+   }
+
+   Instance::DistanceMode distMode = Instance::DistanceMode::FULL;
+   if (getenv("DISTANCES") && !Instance::parseDistanceMode(getenv("DISTANCES"), distMode)) {
+      cout << "Unknown distance mode: " << getenv("DISTANCES") << endl;
+      return EXIT_FAILURE;
+   }
+   MipModel::Formulation formulation = MipModel::Formulation::VEHICLE;
+   if (getenv("FORMULATION") && !MipModel::parseFormulation(getenv("FORMULATION"), formulation)) {
+      cout << "Unknown formulation: " << getenv("FORMULATION") << endl;
+      return EXIT_FAILURE;
+   }
+   vector <FixAndOptimize::DecompMethod> decompositions;
+   if (getenv("DECOMPOSITIONS") && !FixAndOptimize::parseDecompositions(getenv("DECOMPOSITIONS"), decompositions)) {
+      cout << "Unknown decompositions: " << getenv("DECOMPOSITIONS") << endl;
+      return EXIT_FAILURE;
+   }
+   const bool useCache = !getenv("INSTANCE_CACHE") || string(getenv("INSTANCE_CACHE")) != "0";
+   const string modelCache = getenv("MODEL_CACHE") ? getenv("MODEL_CACHE") : "";
+   const string archiveDir = getenv("ARCHIVE") ? getenv("ARCHIVE") : "";
+   const bool archiveWarmStart = !getenv("ARCHIVE_WARM_START") || string(getenv("ARCHIVE_WARM_START")) != "0";
+   const double archiveInterval = getenv("ARCHIVE_INTERVAL") ? atof(getenv("ARCHIVE_INTERVAL")) : 60.0;
+   const bool symmetryBreaking = getenv("SYMMETRY_BREAKING") && string(getenv("SYMMETRY_BREAKING")) == "1";
+   const bool reducedCostFixing = getenv("REDUCED_COST_FIXING") && string(getenv("REDUCED_COST_FIXING")) == "1";
+   const bool boundPropagation = getenv("BOUND_PROPAGATION") && string(getenv("BOUND_PROPAGATION")) == "1";
+   const bool partnerTiming = getenv("PARTNER_TIMING") && string(getenv("PARTNER_TIMING")) == "1";
+   const bool lowerBound = getenv("LOWER_BOUND") && string(getenv("LOWER_BOUND")) == "1";
+   const double stopGap = getenv("STOP_GAP") ? atof(getenv("STOP_GAP")) : RunSettings().stopGap;
+
+   unique_ptr <TraceLog> trace;
+   if (getenv("TRACE"))
+      trace.reset(new TraceLog(getenv("TRACE")));
+
+   // Responses are the only output on stdout; anything else the solver
+   // prints goes to stderr.
+   ostream out(cout.rdbuf());
+   cout.rdbuf(cerr.rdbuf());
+
+   // Instances are owned by the server (not shared through a pool), since
+   // they may be changed by requests.
+   map <string, Resident> residents;
+
+   auto resident = [&] (const string &path) -> Resident& {
+      Resident &res = residents[path];
+      if (!res.inst) {
+         try {
+            res.inst.reset(new Instance(path.c_str(), distMode, useCache));
+            res.model.reset(new MipModel(*res.inst, modelCache, formulation));
+         } catch (...) {
+            residents.erase(path);
+            throw;
+         }
+      }
+      return res;
+   };
+
+   auto writeResult = [&] (const string &id, MipModel &model, const RunResult &res) {
+      const auto routes = model.routes();
+      for (size_t v = 0; v < routes.size(); ++v) {
+         out << "route " << id << " " << v;
+         for (const auto &visit: routes[v])
+            out << " " << visit.first << "/" << visit.second;
+         out << "\n";
+      }
+      out << "result " << id << " " << res.cost << " " << res.timeBest << " " << res.timeTotal << endl;
+   };
+
+   string line;
+   while (getline(cin, line)) {
+      istringstream req(line);
+      string cmd;
+      if (!(req >> cmd))
+         continue;
+
+      if (cmd == "quit") {
+         break;
+
+      } else if (cmd == "load") {
+         string path;
+         if (!(req >> path) || !ifstream(path)) {
+            out << "error - instance " << path << " could not be read" << endl;
+            continue;
+         }
+         auto t0 = chrono::steady_clock::now();
+         try {
+            resident(path);
+         } catch (const exception &e) {
+            out << "error - instance " << path << " could not be read: " << e.what() << endl;
+            continue;
+         }
+         out << "loaded " << path << " " <<
+            chrono::duration<double>(chrono::steady_clock::now() - t0).count() << endl;
+
+      } else if (cmd == "unload") {
+         string path;
+         req >> path;
+         residents.erase(path);
+         out << "unloaded " << path << endl;
+
+      } else if (cmd == "solve" || cmd == "reoptimize") {
+         string id, path;
+         if (!(req >> id >> path)) {
+            out << "error - malformed request: " << line << endl;
+            continue;
+         }
+         if (!residents.count(path) && !ifstream(path)) {
+            out << "error " << id << " instance " << path << " could not be read" << endl;
+            continue;
+         }
+
+         RunSettings settings;
+         settings.trace = trace.get();
+         settings.archiveDir = archiveDir;
+         settings.archiveWarmStart = archiveWarmStart;
+         settings.archiveInterval = archiveInterval;
+         settings.symmetryBreaking = symmetryBreaking;
+         settings.decompositions = decompositions;
+         settings.reducedCostFixing = reducedCostFixing;
+         settings.boundPropagation = boundPropagation;
+         settings.partnerTiming = partnerTiming;
+         settings.lowerBound = lowerBound;
+         settings.stopGap = stopGap;
+         if (!parseOptions(req, settings)) {
+            out << "error " << id << " invalid option in request: " << line << endl;
+            continue;
+         }
+         settings.progress = [&] (int iter, double elapsed, double obj) {
+            out << "progress " << id << " " << iter << " " << elapsed << " " << obj << endl;
+         };
+
+         Resident *res = nullptr;
+         try {
+            res = &resident(path);
+         } catch (const exception &e) {
+            out << "error " << id << " instance " << path << " could not be read: " << e.what() << endl;
+            continue;
+         }
+
+         RunResult result;
+         try {
+            if (cmd == "solve") {
+               res->model->unfixSolution();
+               result = runFixAndOptimize(*res->model, settings);
+            } else if (!res->reopt) {
+               out << "error " << id << " no plan to reoptimize; solve the instance first" << endl;
+               continue;
+            } else if (!res->reopt->reoptimize(settings, result)) {
+               out << "error " << id << " no feasible plan found" << endl;
+               res->reopt.reset();
+               continue;
+            }
+         } catch (const exception &e) {
+            // The state of the model is unknown; it is built again on the next request.
+            out << "error " << id << " " << e.what() << endl;
+            residents.erase(path);
+            continue;
+         }
+
+         writeResult(id, *res->model, result);
+         res->reopt.reset(new Reoptimizer(*res->inst, *res->model));
+
+      } else if (cmd == "tw" || cmd == "cancel" || cmd == "add") {
+         string path;
+         req >> path;
+         if (!residents.count(path) || !residents[path].reopt) {
+            out << "error - no plan for instance " << path << "; solve it first" << endl;
+            continue;
+         }
+         Resident &res = residents[path];
+         const Instance &inst = *res.inst;
+
+         int node = -1;
+         if (cmd == "tw") {
+            double twMin, twMax;
+            if (req >> node >> twMin >> twMax && node >= 1 && node < inst.numNodes()-1 && twMin <= twMax)
+               res.reopt->changeTimeWindow(node, twMin, twMax);
+            else
+               node = -1;
+         } else if (cmd == "cancel") {
+            if (req >> node && node >= 1 && node < inst.numNodes()-1)
+               res.reopt->cancelPatient(node);
+            else
+               node = -1;
+         } else {
+            Instance::Patient patient;
+            patient.reqSkills.assign(inst.numSkills(), 0);
+            patient.procTime.assign(inst.numSkills(), 0.0);
+
+            string svcType, visit;
+            bool valid = bool(req >> patient.posX >> patient.posY >> patient.twMin >> patient.twMax >> svcType >>
+               patient.deltaMin >> patient.deltaMax) && parseSvcType(svcType, patient.svcType) &&
+               patient.twMin <= patient.twMax && patient.deltaMin <= patient.deltaMax;
+            // Counts distinct skills; a skill given twice is rejected.
+            int numVisits = 0;
+            while (valid && req >> visit) {
+               int s = -1;
+               double procTime = 0.0;
+               valid = sscanf(visit.c_str(), "%d:%lf", &s, &procTime) == 2 && s >= 0 && s < inst.numSkills() &&
+                  !patient.reqSkills[s] && procTime >= 0.0;
+               if (valid) {
+                  patient.reqSkills[s] = 1;
+                  patient.procTime[s] = procTime;
+                  ++numVisits;
+               }
+            }
+            if (valid && numVisits == (patient.svcType == Instance::SINGLE ? 1 : 2))
+               node = res.reopt->addPatient(patient);
+         }
+
+         if (node == -1)
+            out << "error - malformed request: " << line << endl;
+         else
+            out << "changed " << path << " " << node << endl;
+
+      } else {
+         out << "error - unknown request: " << cmd << endl;
+      }
+   }
+
+   return EXIT_SUCCESS;
+}